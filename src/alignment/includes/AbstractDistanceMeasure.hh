@@ -38,6 +38,8 @@ namespace alignment
 /** @class AbstractDistanceMeasure
  *
  * This class declares the abstract interface for alignment scoring schemes.
+ * A scoring scheme is immutable once constructed, so that the worker
+ * threads can share it without synchronisation.
  */
 class AbstractDistanceMeasure
 {
@@ -49,12 +51,12 @@ class AbstractDistanceMeasure
 
   virtual ~AbstractDistanceMeasure() {}
 
-  virtual double d(common::Symbol &a, common::Symbol &b) = 0;
+  virtual double d(const common::Symbol &a, const common::Symbol &b) const = 0;
 
-  virtual common::Symbol match(common::Symbol &a, common::Symbol &b) = 0;
+  virtual common::Symbol match(const common::Symbol &a, const common::Symbol &b) const = 0;
 
   inline
-  double getDelta()
+  double getDelta() const
   {
     return m_delta;
   }
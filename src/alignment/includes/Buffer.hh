@@ -0,0 +1,242 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Buffer.hh
+ * Declaration and implementation of the aligned, pre-faulted buffers of the alignments.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __BUFFER_HH__
+#define __BUFFER_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif /* HAVE_SYS_MMAN_H */
+
+#include <boost/cstdint.hpp>
+
+
+namespace alignment
+{
+
+
+/** @enum pages_t
+ * the pages backing the large buffers.
+ */
+enum pages_t {
+  SMALL_PAGES = 0,              /* the pages of the allocator */
+  TRANSPARENT_HUGE_PAGES = 1,   /* huge page aligned and advised for transparent huge pages */
+  EXPLICIT_HUGE_PAGES = 2       /* reserved huge pages, transparent huge pages if none are left */
+};
+
+
+/** @return the process-wide pages backing the buffers allocated from now on */
+inline pages_t & pagePolicy()
+{
+  static pages_t policy = SMALL_PAGES;
+  return policy;
+}
+
+
+/** @class Buffer
+ *
+ * This class keeps a contiguous array of trivially copyable elements
+ * aligned to a cache line. Buffers of at least one huge page can be
+ * backed by huge pages to reduce the TLB misses of the large dynamic
+ * programming matrices and score tables. The memory is zeroed when it
+ * is allocated, so that all page faults happen up front, on the node
+ * of the allocating thread.
+ */
+template <typename T>
+class Buffer
+{
+ public:
+  static const std::size_t ALIGNMENT = 64;
+  static const std::size_t HUGE_PAGE = 2 << 20;
+
+  Buffer() : m_data(NULL), m_capacity(0), m_bytes(0), m_mapped(false) {}
+
+  Buffer(const Buffer &p_other) : m_data(NULL), m_capacity(0), m_bytes(0), m_mapped(false)
+  {
+    allocate(p_other.m_capacity);
+    std::copy(p_other.m_data, p_other.m_data + p_other.m_capacity, m_data);
+  }
+
+  Buffer & operator=(const Buffer &p_other)
+  {
+    if (this != &p_other) {
+      allocate(p_other.m_capacity);
+      std::copy(p_other.m_data, p_other.m_data + p_other.m_capacity, m_data);
+    }
+    return *this;
+  }
+
+  ~Buffer()
+  {
+    release();
+  }
+
+  /** @fn void allocate(std::size_t p_n)
+   * Make room for at least the given number of elements. The contents
+   * are lost, if the buffer has to grow.
+   */
+  void allocate(std::size_t p_n)
+  {
+    if (p_n <= m_capacity) {
+      return;
+    }
+    release();
+
+    std::size_t bytes = p_n * sizeof(T);
+    void *data = NULL;
+
+#ifdef HAVE_SYS_MMAN_H
+    if (pagePolicy() != SMALL_PAGES && bytes >= HUGE_PAGE) {
+      data = map(bytes);
+    }
+#endif /* HAVE_SYS_MMAN_H */
+
+    if (data == NULL) {
+      bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+      if (posix_memalign(&data, ALIGNMENT, bytes) != 0) {
+        throw std::bad_alloc();
+      }
+    }
+
+    // touch every page now rather than in the middle of the alignments
+    std::memset(data, 0, bytes);
+
+    m_data = static_cast<T*>(data);
+    m_capacity = bytes / sizeof(T);
+    m_bytes = bytes;
+  }
+
+  /** @return the number of elements the buffer holds */
+  std::size_t capacity() const
+  {
+    return m_capacity;
+  }
+
+  T * data()
+  {
+    return m_data;
+  }
+
+  const T * data() const
+  {
+    return m_data;
+  }
+
+  T & operator[](std::size_t i)
+  {
+    return m_data[i];
+  }
+
+  const T & operator[](std::size_t i) const
+  {
+    return m_data[i];
+  }
+
+  /** @fn void release()
+   * Free the elements of the buffer.
+   */
+  void release()
+  {
+    if (m_data != NULL) {
+#ifdef HAVE_SYS_MMAN_H
+      if (m_mapped) {
+        munmap(m_data, m_bytes);
+      } else {
+        free(m_data);
+      }
+#else
+      free(m_data);
+#endif /* HAVE_SYS_MMAN_H */
+    }
+
+    m_data = NULL;
+    m_capacity = 0;
+    m_bytes = 0;
+    m_mapped = false;
+  }
+
+ private:
+#ifdef HAVE_SYS_MMAN_H
+  void * map(std::size_t &p_bytes)
+  {
+    std::size_t bytes = (p_bytes + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+
+# ifdef MAP_HUGETLB
+    if (pagePolicy() == EXPLICIT_HUGE_PAGES) {
+      void *data = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (data != MAP_FAILED) {
+        p_bytes = bytes;
+        m_mapped = true;
+        return data;
+      }
+    }
+# endif /* MAP_HUGETLB */
+
+    // map one more huge page and trim the mapping to a huge page boundary
+    char *raw = static_cast<char*>(mmap(NULL, bytes + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (raw == MAP_FAILED) {
+      return NULL;
+    }
+
+    char *data = reinterpret_cast<char*>((reinterpret_cast<boost::uintptr_t>(raw) + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1));
+    std::size_t head = data - raw;
+    if (head > 0) {
+      munmap(raw, head);
+    }
+    if (HUGE_PAGE - head > 0) {
+      munmap(data + bytes, HUGE_PAGE - head);
+    }
+
+# ifdef MADV_HUGEPAGE
+    madvise(data, bytes, MADV_HUGEPAGE);
+# endif /* MADV_HUGEPAGE */
+
+    p_bytes = bytes;
+    m_mapped = true;
+    return data;
+  }
+#endif /* HAVE_SYS_MMAN_H */
+
+  T *m_data;
+  std::size_t m_capacity;
+  std::size_t m_bytes;
+  bool m_mapped;
+};
+
+
+}
+
+
+#endif
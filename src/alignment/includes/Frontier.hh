@@ -0,0 +1,199 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Frontier.hh
+ * Declaration and implementation of the extension of the alignment scores of growing sequences.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __FRONTIER_HH__
+#define __FRONTIER_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "AbstractDistanceMeasure.hh"
+#include "MemoryPool.hh"
+#include "Profile.hh"
+#include "Types.hh"
+
+
+namespace alignment
+{
+
+
+/** @class Frontier
+ *
+ * This class extends the scores of a pair of sequences, after symbols
+ * have been appended to either or both of them. The cells of a matrix
+ * only depend on the cells above and to the left, so the last row, the
+ * last column and the maximum of the matrix of the previous sequences
+ * are enough to compute the new columns of the previous rows and then
+ * the new rows. A frontier is laid out as the last row (one cell per
+ * symbol of the second sequence and the border), the last column (one
+ * cell per symbol of the first sequence and the border) and the
+ * maximum. The scores are identical to the ones of SW and NW on the
+ * whole sequences. No tracebacks are computed.
+ */
+class Frontier
+{
+ public:
+  Frontier(bool p_local, double p_delta)
+      : m_local(p_local), m_delta(p_delta),
+        m_floor(p_local ? 0.0 : -std::numeric_limits<double>::infinity())
+  {}
+  ~Frontier() {}
+
+  /** @return the number of cells of the frontier of a pair of the given lengths */
+  static std::size_t size(boost::uint32_t p_len_a, boost::uint32_t p_len_b)
+  {
+    return static_cast<std::size_t>(p_len_a) + p_len_b + 3;
+  }
+
+  /** @fn double extend(common::StringVec &seq_a, common::StringVec &seq_b, boost::uint32_t prev_a, boost::uint32_t prev_b, const double *prev, double *next, const AbstractDistanceMeasure &scoring_matrix, MemoryPool &mem) const
+   * Compute the frontier of the whole sequences from the one of their prefixes.
+   *
+   * @param boost::uint32_t the length of the prefix of the first sequence
+   * @param boost::uint32_t the length of the prefix of the second sequence
+   * @param const double * the frontier of the prefixes
+   * @param double * the frontier of the whole sequences
+   * @return the score of the whole sequences
+   */
+  double extend(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      boost::uint32_t prev_a,
+      boost::uint32_t prev_b,
+      const double *prev,
+      double *next,
+      const AbstractDistanceMeasure & scoring_matrix,
+      MemoryPool &mem) const {
+    return run(seq_a, seq_b, prev_a, prev_b, prev, next, SchemeScorer(scoring_matrix, seq_a, seq_b), mem);
+  }
+
+  /** @fn double extend(common::StringVec &seq_a, common::StringVec &seq_b, boost::uint32_t prev_a, boost::uint32_t prev_b, const double *prev, double *next, const Profile &profile, const std::vector<boost::uint32_t> &cols_b, MemoryPool &mem) const
+   * Compute the frontier of the whole sequences from the one of their
+   * prefixes, gathering the cells from the profile of the first sequence.
+   */
+  double extend(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      boost::uint32_t prev_a,
+      boost::uint32_t prev_b,
+      const double *prev,
+      double *next,
+      const Profile & profile,
+      const std::vector<boost::uint32_t> & cols_b,
+      MemoryPool &mem) const {
+    return run(seq_a, seq_b, prev_a, prev_b, prev, next, ProfileScorer(profile, cols_b), mem);
+  }
+
+  /** @fn static void empty(double *frontier)
+   * Write the frontier of two empty sequences.
+   */
+  static void empty(double *frontier)
+  {
+    std::fill(frontier, frontier + size(0, 0), 0.0);
+  }
+
+ private:
+  template <typename Scorer>
+  double run(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      boost::uint32_t prev_a,
+      boost::uint32_t prev_b,
+      const double *prev,
+      double *next,
+      const Scorer & score,     /* scores of the cells */
+      MemoryPool &mem) const {
+
+    boost::uint32_t N_a = seq_a.size();
+    boost::uint32_t N_b = seq_b.size();
+    const double *prev_row = prev;
+    const double *prev_col = prev + prev_b + 1;
+    double *next_row = next;
+    double *next_col = next + N_b + 1;
+    double H_max = prev[prev_b + prev_a + 2];
+
+    // rows 0 and 1 alternate as the previous and the current row
+    mem.checkDimensions(2, N_b + 1);
+
+    // the new columns of the previous rows continue the previous last column
+    double *top = mem.H()[0];
+    top[prev_b] = prev_col[0];
+    for (boost::uint32_t j = prev_b + 1; j <= N_b; ++j) {
+      top[j] = m_local ? 0.0 : -static_cast<boost::int32_t>(j) * m_delta;
+    }
+    next_col[0] = top[N_b];
+
+    for (boost::uint32_t i = 1; i <= prev_a; i++) {
+      typename Scorer::Row d = score.row(i-1);
+      const double *up = mem.H()[(i-1) & 1];
+      double *cur = mem.H()[i & 1];
+
+      cur[prev_b] = prev_col[i];
+      for (boost::uint32_t j = prev_b + 1; j <= N_b; j++) {
+        cur[j] = std::max(std::max(up[j-1] + d(j-1), up[j] - m_delta), std::max(cur[j-1] - m_delta, m_floor));
+        H_max = std::max(H_max, cur[j]);
+      }
+      next_col[i] = cur[N_b];
+    }
+
+    // the previous last row and its new columns start the new rows
+    std::copy(prev_row, prev_row + prev_b + 1, mem.H()[prev_a & 1]);
+
+    for (boost::uint32_t i = prev_a + 1; i <= N_a; i++) {
+      typename Scorer::Row d = score.row(i-1);
+      const double *up = mem.H()[(i-1) & 1];
+      double *cur = mem.H()[i & 1];
+
+      cur[0] = m_local ? 0.0 : -static_cast<boost::int32_t>(i) * m_delta;
+      for (boost::uint32_t j = 1; j <= N_b; j++) {
+        cur[j] = std::max(std::max(up[j-1] + d(j-1), up[j] - m_delta), std::max(cur[j-1] - m_delta, m_floor));
+        H_max = std::max(H_max, cur[j]);
+      }
+      next_col[i] = cur[N_b];
+    }
+
+    const double *last = mem.H()[N_a & 1];
+    std::copy(last, last + N_b + 1, next_row);
+    next_col[N_a + 1] = H_max;
+
+    return m_local ? H_max : last[N_b];
+  }
+
+  bool m_local;
+  double m_delta;
+  double m_floor;
+};
+
+
+}
+
+
+#endif
@@ -31,71 +31,147 @@
 #endif /* __STDC_CONSTANT_MACROS */
 
 #include <algorithm>
-#include <vector>
+#include <cstddef>
+#include <new>
 
 #include <boost/cstdint.hpp>
-#include <boost/foreach.hpp>
+
+#include "Buffer.hh"
+#include "Trace.hh"
 
 
 namespace alignment
 {
 
-typedef std::vector<std::vector<double> > DMatrix;
-typedef std::vector<std::vector<boost::int32_t> > IMatrix;
+
+/** @class Matrix
+ *
+ * This class lays a dynamic programming matrix out row by row in a
+ * contiguous buffer. The rows are exactly as wide as the last shape,
+ * so that the matrices of small pairs stay compact.
+ */
+template <typename T>
+class Matrix
+{
+ public:
+  Matrix() : m_rows(0), m_cols(0) {}
+
+  /** @fn void reserve(std::size_t p_cells)
+   * Make room for at least the given number of cells. The contents are lost, if the matrix has to grow.
+   */
+  void reserve(std::size_t p_cells)
+  {
+    m_buffer.allocate(p_cells);
+  }
+
+  void shape(boost::uint32_t p_rows, boost::uint32_t p_cols)
+  {
+    m_rows = p_rows;
+    m_cols = p_cols;
+  }
+
+  void fill(T p_value)
+  {
+    std::fill_n(m_buffer.data(), static_cast<std::size_t>(m_rows) * m_cols, p_value);
+  }
+
+  std::size_t capacity() const
+  {
+    return m_buffer.capacity();
+  }
+
+  void release()
+  {
+    m_buffer.release();
+  }
+
+  T * operator[](std::size_t i)
+  {
+    return m_buffer.data() + i * m_cols;
+  }
+
+  const T * operator[](std::size_t i) const
+  {
+    return m_buffer.data() + i * m_cols;
+  }
+
+ private:
+  Buffer<T> m_buffer;
+  boost::uint32_t m_rows;
+  boost::uint32_t m_cols;
+};
+
+
+typedef Matrix<double> DMatrix;
+typedef Matrix<boost::int32_t> IMatrix;
 
 /** @class MemoryPool
  *
  * This class is just a simple wrapper around the dynamic programming
  * matrices of the alignment algorithms. This memory pool is passed by
  * the calling function to the alignments in order to avoid
- * unnecessary memory (de)allocation in batch mode.
+ * unnecessary memory (de)allocation in batch mode. It also holds the
+ * arena the tracebacks of the alignments are written to. The matrices
+ * can be capped, in which case the alignments of larger pairs fall
+ * back to computing their scores in linear space.
  */
 class MemoryPool
 {
  public:
-  MemoryPool() {}
+  /** bytes of a cell of the three matrices */
+  static const std::size_t CELL = sizeof(double) + 2 * sizeof(boost::int32_t);
+
+  MemoryPool() : m_cap(0) {}
   ~MemoryPool() {}
 
-  void checkDimensions(boost::uint32_t p_rows, boost::uint32_t p_cols)
+  /** @fn void cap(std::size_t p_bytes)
+   * Limit the matrices to the given number of bytes, 0 for no limit.
+   */
+  void cap(std::size_t p_bytes)
   {
-    if (p_rows >= m_H.size()) {
-      m_H.resize(p_rows * 2);
-    }
-    if (p_rows >= m_I_i.size()) {
-      m_I_i.resize(p_rows * 2);
-    }
-    if (p_rows >= m_I_j.size()) {
-      m_I_j.resize(p_rows * 2);
-    }
-    if (p_cols >= m_H[0].size()) {
-      BOOST_FOREACH(std::vector<double> & row, m_H) {
-        row.resize(p_cols * 2);
-      }
-    }
-    if (p_cols >= m_I_i[0].size()) {
-      BOOST_FOREACH(std::vector<boost::int32_t> & row, m_I_i) {
-        row.resize(p_cols * 2);
-      }
+    m_cap = p_bytes;
+  }
+
+  /** @return true, if the matrices of the given dimensions fit into the cap */
+  bool fits(boost::uint32_t p_rows, boost::uint32_t p_cols) const
+  {
+    return (m_cap == 0) || (static_cast<std::size_t>(p_rows) * p_cols * CELL <= m_cap);
+  }
+
+  /** @fn void reserve(boost::uint32_t p_rows, boost::uint32_t p_cols)
+   * Allocate and pre-fault the matrices of the given dimensions up front, if they fit into the cap.
+   * The reservation is only a hint: if the matrices cannot be allocated, they grow with the pairs instead.
+   */
+  void reserve(boost::uint32_t p_rows, boost::uint32_t p_cols)
+  {
+    if (!fits(p_rows, p_cols)) {
+      return;
     }
-    if (p_cols >= m_I_j[0].size()) {
-      BOOST_FOREACH(std::vector<boost::int32_t> & row, m_I_j) {
-        row.resize(p_cols * 2);
-      }
+
+    try {
+      grow(static_cast<std::size_t>(p_rows) * p_cols);
+    } catch (std::bad_alloc &) {
+      // the matrices allocated before the failure would pass for all three
+      m_H.release();
+      m_I_i.release();
+      m_I_j.release();
     }
   }
 
+  void checkDimensions(boost::uint32_t p_rows, boost::uint32_t p_cols)
+  {
+    grow(static_cast<std::size_t>(p_rows) * p_cols);
+    m_H.shape(p_rows, p_cols);
+    m_I_i.shape(p_rows, p_cols);
+    m_I_j.shape(p_rows, p_cols);
+  }
+
   void reset(boost::uint32_t p_rows, boost::uint32_t p_cols)
   {
     checkDimensions(p_rows, p_cols);
-    BOOST_FOREACH(std::vector<double> & row, m_H) {
-      std::fill_n(row.begin(), p_cols, 0.0);
-    }
-    BOOST_FOREACH(std::vector<boost::int32_t> & row, m_I_i) {
-      std::fill_n(row.begin(), p_cols, 0.0);
-    }
-    BOOST_FOREACH(std::vector<boost::int32_t> & row, m_I_j) {
-      std::fill_n(row.begin(), p_cols, 0.0);
-    }
+    m_H.fill(0.0);
+    m_I_i.fill(0);
+    m_I_j.fill(0);
   }
 
   DMatrix & H()
@@ -113,10 +189,33 @@ class MemoryPool
     return m_I_j;
   }
 
+  TraceArena & trace()
+  {
+    return m_trace;
+  }
+
  private:
+  void grow(std::size_t p_cells)
+  {
+    if (p_cells <= m_H.capacity()) {
+      return;
+    }
+
+    // grow geometrically, but not beyond the cap if the cells fit into it
+    std::size_t cells = std::max(p_cells, 2 * m_H.capacity());
+    if (m_cap > 0 && p_cells * CELL <= m_cap) {
+      cells = std::min(cells, m_cap / CELL);
+    }
+    m_H.reserve(cells);
+    m_I_i.reserve(cells);
+    m_I_j.reserve(cells);
+  }
+
+  std::size_t m_cap;
   DMatrix m_H;
   IMatrix m_I_i;
   IMatrix m_I_j;
+  TraceArena m_trace;
 };
 
 
@@ -46,6 +46,7 @@
 #include <boost/cstdint.hpp>
 #include <boost/foreach.hpp>
 
+#include "Profile.hh"
 #include "SimilarityAlgorithm.hh"
 #include "Types.hh"
 
@@ -64,10 +65,31 @@ class NW : public SimilarityAlgorithm
   ~NW() {}
 
   alignmentResult align(
-      common::StringVec & seq_a, /* sequence 1 */
-      common::StringVec & seq_b, /* sequence 2 */
-      AbstractDistanceMeasure & scoring_matrix,
-      MemoryPool & mem) { /* scoring scheme */
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      const AbstractDistanceMeasure & scoring_matrix,
+      MemoryPool &mem) {
+    return run(seq_a, seq_b, SchemeScorer(scoring_matrix, seq_a, seq_b), scoring_matrix, mem);
+  }
+
+  alignmentResult align(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      const Profile & profile,
+      const std::vector<boost::uint32_t> & cols_b,
+      const AbstractDistanceMeasure & scoring_matrix,
+      MemoryPool &mem) {
+    return run(seq_a, seq_b, ProfileScorer(profile, cols_b), scoring_matrix, mem);
+  }
+
+ private:
+  template <typename Scorer>
+  alignmentResult run(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      const Scorer & score,     /* scores of the cells */
+      const AbstractDistanceMeasure & scoring_matrix,
+      MemoryPool &mem) {
 #ifndef NDEBUG
     std::cout << "NW::operator()" << std::endl;
 #endif /* NDEBUG */
@@ -75,19 +97,31 @@ class NW : public SimilarityAlgorithm
     boost::uint32_t N_a = seq_a.size();
     boost::uint32_t N_b = seq_b.size();
 
+    if (!mem.fits(N_a + 1, N_b + 1)) {
+      return linear(seq_a, seq_b, score, scoring_matrix, mem);
+    }
+
     // initialize H
     /* in this case, we only initialize row 0 and col 0 */
+    /* the border cells point along the border towards the origin */
     mem.reset(N_a + 1, N_b + 1);
-    for (boost::int32_t i = 1; i < N_a+1; ++i) mem.H()[i][0] = -i * scoring_matrix.getDelta();
-    for (boost::int32_t j = 1; j < N_b+1; ++j) mem.H()[0][j] = -j * scoring_matrix.getDelta();
+    for (boost::int32_t i = 1; i < N_a+1; ++i) {
+      mem.H()[i][0] = -i * scoring_matrix.getDelta();
+      mem.I_i()[i][0] = i-1;
+    }
+    for (boost::int32_t j = 1; j < N_b+1; ++j) {
+      mem.H()[0][j] = -j * scoring_matrix.getDelta();
+      mem.I_j()[0][j] = j-1;
+    }
 
     double temp[3];
     double *mdit;
 
     for (boost::uint32_t i = 1; i <= N_a; i++) {
+      typename Scorer::Row d = score.row(i-1);
       for (boost::uint32_t j = 1; j <= N_b; j++) {
         // calculate all possible paths to improve on prev optimal alignments
-        temp[0] = mem.H()[i-1][j-1] + scoring_matrix.d(seq_a[i-1], seq_b[j-1]);
+        temp[0] = mem.H()[i-1][j-1] + d(j-1);
         temp[1] = mem.H()[i-1][j] - scoring_matrix.getDelta();
         temp[2] = mem.H()[i][j-1] - scoring_matrix.getDelta();
 
@@ -125,38 +159,72 @@ class NW : public SimilarityAlgorithm
     // store results
     alignmentResult result;
     result.score = mem.H()[N_a][N_b];
-    result.alignment.resize(2);
 
     if (!m_justscores) {
       /* we now backtrack from the bottom right cell of H */
       boost::int32_t current_i = N_a, current_j = N_b;
       boost::int32_t next_i = mem.I_i()[current_i][current_j];
       boost::int32_t next_j = mem.I_j()[current_i][current_j];
-      boost::int32_t tick = 0;
 
-      common::StringVec consensus_a, consensus_b;
-      consensus_a.resize(N_a + N_b + 2);
-      consensus_b.resize(N_a + N_b + 2);
+      TraceArena &arena = mem.trace();
+      arena.open(result.trace);
 
       /* we have to go from MN to 00 */
       while (current_i != 0 || current_j != 0) {
-        if (next_i == current_i) { consensus_a[tick] = "-"; } // deletion in A
-        else { consensus_a[tick] = scoring_matrix.match(seq_a[current_i-1], seq_b[current_j-1]); }      // match/mismatch in A
-
-        if (next_j == current_j) { consensus_b[tick] = "-"; } // deletion in B
-        else { consensus_b[tick] = scoring_matrix.match(seq_a[current_i-1], seq_b[current_j-1]); }      // match/mismatch in B
+        if (next_i == current_i) { arena.push(result.trace, TraceArena::INSERT); }       // deletion in A
+        else if (next_j == current_j) { arena.push(result.trace, TraceArena::DELETE); }  // deletion in B
+        else { arena.push(result.trace, TraceArena::MATCH); }                            // match/mismatch
 
         current_i = next_i;
         current_j = next_j;
         next_i = mem.I_i()[current_i][current_j];
         next_j = mem.I_j()[current_i][current_j];
-        tick++;
       }
 
-      for(boost::int32_t i = tick-1; i >= 0; i--) { result.alignment[0].push_back(consensus_a[i]); }
-      for(boost::int32_t j = tick-1; j >= 0; j--) { result.alignment[1].push_back(consensus_b[j]); }
+      arena.close(result.trace);
+      result.trace.end_i = N_a;
+      result.trace.end_j = N_b;
+    }
+
+    return result;
+  }
+
+  /** @fn alignmentResult linear(common::StringVec &seq_a, common::StringVec &seq_b, const Scorer &score, const AbstractDistanceMeasure &scoring_matrix, MemoryPool &mem)
+   * Compute the score of a pair exceeding the cap of the memory pool
+   * from two rows of H, without traceback.
+   */
+  template <typename Scorer>
+  alignmentResult linear(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      const Scorer & score,     /* scores of the cells */
+      const AbstractDistanceMeasure & scoring_matrix,
+      MemoryPool &mem) {
+
+    boost::uint32_t N_a = seq_a.size();
+    boost::uint32_t N_b = seq_b.size();
+    double delta = scoring_matrix.getDelta();
+
+    mem.reset(2, N_b + 1);
+    for (boost::uint32_t j = 1; j <= N_b; ++j) {
+      mem.H()[0][j] = -static_cast<boost::int32_t>(j) * delta;
+    }
+
+    for (boost::uint32_t i = 1; i <= N_a; i++) {
+      typename Scorer::Row d = score.row(i-1);
+      const double *prev = mem.H()[(i-1) & 1];
+      double *cur = mem.H()[i & 1];
+
+      cur[0] = -static_cast<boost::int32_t>(i) * delta;
+      for (boost::uint32_t j = 1; j <= N_b; j++) {
+        cur[j] = std::max(std::max(prev[j-1] + d(j-1), prev[j] - delta), cur[j-1] - delta);
+      }
     }
 
+    alignmentResult result;
+    result.score = mem.H()[N_a & 1][N_b];
+    result.capped = true;
+
     return result;
   }
 };
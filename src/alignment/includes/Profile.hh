@@ -0,0 +1,168 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Profile.hh
+ * Declaration and implementation of the query profiles and the cell scorers of the alignments.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __PROFILE_HH__
+#define __PROFILE_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "AbstractDistanceMeasure.hh"
+#include "Types.hh"
+
+
+namespace alignment
+{
+
+
+/** @class Profile
+ *
+ * This class keeps the scores of the symbols of a query against the
+ * symbols of a target alphabet. Row x holds the scores of the x-th
+ * symbol of the query against every symbol of the alphabet, so a
+ * target encoded as indices into the alphabet is scored by a gather
+ * from a small table instead of a lookup in the scoring scheme.
+ */
+class Profile
+{
+ public:
+  Profile() : m_cols(0) {}
+
+  /** @fn void build(const common::StringVec &p_query, const common::StringVec &p_alphabet, const AbstractDistanceMeasure &p_scheme)
+   * Score every symbol of the query against every symbol of the alphabet.
+   */
+  void build(const common::StringVec &p_query, const common::StringVec &p_alphabet, const AbstractDistanceMeasure &p_scheme)
+  {
+    m_cols = p_alphabet.size();
+    m_scores.resize(p_query.size() * m_cols);
+
+    for (boost::uint32_t x = 0; x < p_query.size(); ++x) {
+      double *scores = &m_scores[x * m_cols];
+      for (boost::uint32_t c = 0; c < m_cols; ++c) {
+        scores[c] = p_scheme.d(p_query[x], p_alphabet[c]);
+      }
+    }
+  }
+
+  /** @return the scores of the x-th symbol of the query against the alphabet */
+  const double * row(boost::uint32_t x) const
+  {
+    return &m_scores[x * m_cols];
+  }
+
+ private:
+  boost::uint32_t m_cols;
+  std::vector<double> m_scores;
+};
+
+
+/** @class SchemeScorer
+ *
+ * This class scores the cells of an alignment by looking the symbols up
+ * in the scoring scheme.
+ */
+class SchemeScorer
+{
+ public:
+  class Row
+  {
+   public:
+    Row(const AbstractDistanceMeasure &p_scheme, const common::Symbol &p_a, const common::StringVec &p_b)
+        : m_scheme(p_scheme), m_a(p_a), m_b(p_b) {}
+
+    double operator()(boost::uint32_t j) const
+    {
+      return m_scheme.d(m_a, m_b[j]);
+    }
+
+   private:
+    const AbstractDistanceMeasure &m_scheme;
+    const common::Symbol &m_a;
+    const common::StringVec &m_b;
+  };
+
+  SchemeScorer(const AbstractDistanceMeasure &p_scheme, const common::StringVec &p_a, const common::StringVec &p_b)
+      : m_scheme(p_scheme), m_a(p_a), m_b(p_b) {}
+
+  /** @return the scorer of the cells of the i-th symbol of the first sequence */
+  Row row(boost::uint32_t i) const
+  {
+    return Row(m_scheme, m_a[i], m_b);
+  }
+
+ private:
+  const AbstractDistanceMeasure &m_scheme;
+  const common::StringVec &m_a;
+  const common::StringVec &m_b;
+};
+
+
+/** @class ProfileScorer
+ *
+ * This class scores the cells of an alignment by gathering from the
+ * profile of the first sequence at the alphabet indices of the second
+ * sequence.
+ */
+class ProfileScorer
+{
+ public:
+  class Row
+  {
+   public:
+    Row(const double *p_scores, const boost::uint32_t *p_cols) : m_scores(p_scores), m_cols(p_cols) {}
+
+    double operator()(boost::uint32_t j) const
+    {
+      return m_scores[m_cols[j]];
+    }
+
+   private:
+    const double *m_scores;
+    const boost::uint32_t *m_cols;
+  };
+
+  ProfileScorer(const Profile &p_profile, const std::vector<boost::uint32_t> &p_cols)
+      : m_profile(p_profile), m_cols(p_cols.empty() ? NULL : &p_cols[0]) {}
+
+  Row row(boost::uint32_t i) const
+  {
+    return Row(m_profile.row(i), m_cols);
+  }
+
+ private:
+  const Profile &m_profile;
+  const boost::uint32_t *m_cols;
+};
+
+
+}
+
+
+#endif
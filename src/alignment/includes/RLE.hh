@@ -0,0 +1,226 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file RLE.hh
+ * Declaration and implementation of the run-length encoded alignment scores.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __RLE_HH__
+#define __RLE_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include <boost/cstdint.hpp>
+
+#include "Profile.hh"
+#include "SimilarityAlgorithm.hh"
+#include "Types.hh"
+
+
+namespace alignment
+{
+
+
+/** @class RLE
+ *
+ * This class computes the scores of the local (Smith-Waterman) and
+ * global (Needleman-Wunsch) alignments on the runs of identical
+ * symbols of both sequences. Within the block spanned by two runs the
+ * substitution score is constant, so the best path from any cell on the
+ * top or left edge of the block to any cell on the bottom or right edge
+ * has a closed form for the linear gap model: as many diagonal steps as
+ * possible if a substitution beats two gaps, otherwise gaps only. The
+ * far edges of a p x q block then follow from prefix and sliding window
+ * maxima over the near edges in O(p + q) instead of O(pq), so the whole
+ * matrix costs O(R_a N_b + R_b N_a) for R_a and R_b runs. Only the
+ * scores are computed, the result does not carry an alignment. The
+ * scores equal those of the full kernels up to rounding: the closed
+ * form sums the substitutions and gaps of a path in another order than
+ * the recurrence of the cells, so the last digit may differ.
+ */
+class RLE : public SimilarityAlgorithm
+{
+ private:
+  bool m_local;
+
+  /** @fn void edge(const double *top, const double *left, boost::uint32_t p, boost::uint32_t q, double s, double delta, double *prefix, boost::int32_t *window, double *out)
+   * Compute the cells 1..q of the bottom row of a p x q block from its
+   * top row (q + 1 cells) and left column (p + 1 cells). The right
+   * column follows by swapping the roles of both edges.
+   */
+  static void edge(const double *top, const double *left, boost::uint32_t p, boost::uint32_t q,
+                   double s, double delta, double *prefix, boost::int32_t *window, double *out)
+  {
+    const double inf = std::numeric_limits<double>::infinity();
+    // gain of a diagonal step over the two gaps it replaces
+    double e = std::max(s + 2.0 * delta, 0.0);
+    double de = delta - e;
+
+    // left entries more than j rows above the bottom: j diagonal steps
+    for (boost::uint32_t r = 0; r < p; ++r) {
+      prefix[r] = std::max((r == 0) ? -inf : prefix[r - 1], left[r] + delta * r);
+    }
+
+    double topFar = -inf;                     // top entries at least p columns to the left
+    double leftNear = left[p] + de * p;       // left entries at most j rows above the bottom
+    boost::int32_t head = 0, tail = 0;        // sliding window over top entries less than p columns to the left
+    window[tail++] = 0;
+
+    for (boost::uint32_t j = 1; j <= q; ++j) {
+      double value = top[j] + de * j;
+      while (tail > head && top[window[tail - 1]] + de * window[tail - 1] <= value) {
+        tail--;
+      }
+      window[tail++] = j;
+      while (window[head] <= static_cast<boost::int32_t>(j) - static_cast<boost::int32_t>(p)) {
+        head++;
+      }
+
+      if (j >= p) {
+        topFar = std::max(topFar, top[j - p] + delta * (j - p));
+      }
+      if (j <= p) {
+        leftNear = std::max(leftNear, left[p - j] + de * (p - j));
+      }
+
+      double best = std::max(topFar, leftNear) + e * p;
+      best = std::max(best, top[window[head]] + de * window[head] + e * j);
+      if (j < p) {
+        best = std::max(best, prefix[p - j - 1] + e * j);
+      }
+
+      out[j] = best - delta * (p + j);
+    }
+  }
+
+  /** @return the length of the run of identical symbols starting at the given position */
+  static boost::uint32_t length(common::StringVec &seq, boost::uint32_t pos)
+  {
+    boost::uint32_t len = 1;
+    while (pos + len < seq.size() && seq[pos + len] == seq[pos]) {
+      len++;
+    }
+    return len;
+  }
+
+ public:
+  RLE(bool p_local) : SimilarityAlgorithm(), m_local(p_local) {}
+  ~RLE() {}
+
+  alignmentResult align(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      const AbstractDistanceMeasure & scoring_matrix,
+      MemoryPool &mem) {
+    return run(seq_a, seq_b, SchemeScorer(scoring_matrix, seq_a, seq_b), scoring_matrix, mem);
+  }
+
+  alignmentResult align(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      const Profile & profile,
+      const std::vector<boost::uint32_t> & cols_b,
+      const AbstractDistanceMeasure & scoring_matrix,
+      MemoryPool &mem) {
+    return run(seq_a, seq_b, ProfileScorer(profile, cols_b), scoring_matrix, mem);
+  }
+
+ private:
+  template <typename Scorer>
+  alignmentResult run(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      const Scorer & score,     /* scores of the cells */
+      const AbstractDistanceMeasure & scoring_matrix,
+      MemoryPool &mem) {
+
+    boost::uint32_t N_a = seq_a.size();
+    boost::uint32_t N_b = seq_b.size();
+    double delta = scoring_matrix.getDelta();
+
+    // the rows of H serve as the edge buffers of the blocks
+    mem.checkDimensions(5, std::max(N_a, N_b) + 1);
+    double *top = &mem.H()[0][0];
+    double *bottom = &mem.H()[1][0];
+    double *left = &mem.H()[2][0];
+    double *right = &mem.H()[3][0];
+    double *prefix = &mem.H()[4][0];
+    boost::int32_t *window = &mem.I_i()[0][0];
+
+    for (boost::uint32_t j = 0; j <= N_b; ++j) {
+      top[j] = m_local ? 0.0 : -(j * delta);
+    }
+
+    double H_max = 0.;
+
+    for (boost::uint32_t i0 = 0, p = 0; i0 < N_a; i0 += p) {
+      p = length(seq_a, i0);
+      typename Scorer::Row d = score.row(i0);
+
+      for (boost::uint32_t r = 0; r <= p; ++r) {
+        left[r] = m_local ? 0.0 : -((i0 + r) * delta);
+      }
+      bottom[0] = left[p];
+
+      for (boost::uint32_t j0 = 0, q = 0; j0 < N_b; j0 += q) {
+        q = length(seq_b, j0);
+        double s = d(j0);
+
+        edge(top + j0, left, p, q, s, delta, prefix, window, bottom + j0);
+        edge(left, top + j0, q, p, s, delta, prefix, window, right);
+        right[0] = top[j0 + q];
+        right[p] = bottom[j0 + q];
+
+        if (m_local) {
+          for (boost::uint32_t j = j0 + 1; j <= j0 + q; ++j) {
+            bottom[j] = std::max(bottom[j], 0.0);
+            H_max = std::max(H_max, bottom[j]);
+          }
+          for (boost::uint32_t r = 1; r <= p; ++r) {
+            right[r] = std::max(right[r], 0.0);
+            H_max = std::max(H_max, right[r]);
+          }
+        }
+
+        std::swap(left, right);
+      }
+
+      std::swap(top, bottom);
+    }
+
+    alignmentResult result;
+    result.score = m_local ? H_max : top[N_b];
+
+    return result;
+  }
+};
+
+
+}
+
+
+#endif
@@ -45,6 +45,7 @@
 
 #include <boost/cstdint.hpp>
 
+#include "Profile.hh"
 #include "SimilarityAlgorithm.hh"
 #include "Types.hh"
 
@@ -57,67 +58,169 @@ class SW : public SimilarityAlgorithm
 {
  private:
   bool m_justscores;
+  double m_xdrop;
 
  public:
-  SW(bool p_justscores) : SimilarityAlgorithm(), m_justscores(p_justscores) {}
+  /**
+   * @param bool compute just the scores, no traceback
+   * @param double the X-drop: the cells scoring more than X below the running
+   *        maximum are not extended, 0 computes the whole matrix
+   */
+  SW(bool p_justscores, double p_xdrop = 0.0)
+      : SimilarityAlgorithm(), m_justscores(p_justscores), m_xdrop(p_xdrop) {}
   ~SW() {}
 
   alignmentResult align(
       common::StringVec &seq_a, /* sequence 1 */
       common::StringVec &seq_b, /* sequence 2 */
-      AbstractDistanceMeasure & scoring_matrix,
-      MemoryPool &mem) { /* gap penalty */
+      const AbstractDistanceMeasure & scoring_matrix,
+      MemoryPool &mem) {
+    return run(seq_a, seq_b, SchemeScorer(scoring_matrix, seq_a, seq_b), scoring_matrix, mem);
+  }
 
-    boost::uint32_t N_a = seq_a.size();
-    boost::uint32_t N_b = seq_b.size();
-
-    // initialize H
-    mem.reset(N_a + 1, N_b + 1);
+  alignmentResult align(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      const Profile & profile,
+      const std::vector<boost::uint32_t> & cols_b,
+      const AbstractDistanceMeasure & scoring_matrix,
+      MemoryPool &mem) {
+    return run(seq_a, seq_b, ProfileScorer(profile, cols_b), scoring_matrix, mem);
+  }
 
+ private:
+  /** @fn void start(MemoryPool &mem, boost::uint32_t i, boost::uint32_t j)
+   * Mark the (zero) cell (i,j) as the beginning of a subsequence.
+   */
+  void start(MemoryPool &mem, boost::uint32_t i, boost::uint32_t j) const
+  {
+    mem.H()[i][j] = 0.0;
+    mem.I_i()[i][j] = i;
+    mem.I_j()[i][j] = j;
+  }
+
+  /** @fn void cell(MemoryPool &mem, const Row &d, boost::uint32_t i, boost::uint32_t j, double p_delta, double &H_max, boost::uint32_t &i_max, boost::uint32_t &j_max)
+   * Compute the cell (i,j) and keep track of the maximum.
+   */
+  template <typename Row>
+  void cell(MemoryPool &mem, const Row &d, boost::uint32_t i, boost::uint32_t j, double p_delta,
+            double &H_max, boost::uint32_t &i_max, boost::uint32_t &j_max) const
+  {
     double temp[4];
     double *mdit;
 
+    // calculate all possible paths to improve on prev optimal alignments
+    // we assume for 1 and 2 a linear gap scoring scheme. Hence we do not need to apply a max operator
+    //  over previous indices since we know that the max value is attained at the previous index
+    temp[0] = mem.H()[i-1][j-1] + d(j-1);
+    temp[1] = mem.H()[i-1][j] - p_delta;
+    temp[2] = mem.H()[i][j-1] - p_delta;
+    temp[3] = 0.0;
+
+    // get max
+    mdit = std::max_element(temp, temp+4);
+    mem.H()[i][j] = *mdit;
+
+    switch (std::distance(temp, mdit)) {
+      case 0: // score in (i,j) stems from a match/mismatch
+        mem.I_i()[i][j] = i-1;
+        mem.I_j()[i][j] = j-1;
+        break;
+      case 1: // score in (i,j) stems from a del in sequence A
+        mem.I_i()[i][j] = i-1;
+        mem.I_j()[i][j] = j;
+        break;
+      case 2: // score in (i,j) stems from a del in sequence B
+        mem.I_i()[i][j] = i;
+        mem.I_j()[i][j] = j-1;
+        break;
+      case 3: // (i,j) is the beginning of a subsequence
+        mem.I_i()[i][j] = i;
+        mem.I_j()[i][j] = j;
+        break;
+    }
+
+    // store maximum
+    if(mem.H()[i][j] > H_max){
+      H_max = mem.H()[i][j];
+      i_max = i;
+      j_max = j;
+    }
+  }
+
+  template <typename Scorer>
+  alignmentResult run(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      const Scorer & score,     /* scores of the cells */
+      const AbstractDistanceMeasure & scoring_matrix,
+      MemoryPool &mem) {
+
+    boost::uint32_t N_a = seq_a.size();
+    boost::uint32_t N_b = seq_b.size();
+
+    if (!mem.fits(N_a + 1, N_b + 1)) {
+      return linear(seq_a, seq_b, score, scoring_matrix, mem);
+    }
+
     double H_max = 0.;
     boost::uint32_t i_max = 0, j_max = 0;
+    boost::uint64_t skipped = 0;
+
+    if (m_xdrop > 0.0) {
+      // only row 0 is initialised, the cells bordering the band are started as they are read
+      mem.checkDimensions(N_a + 1, N_b + 1);
+      std::fill_n(mem.H()[0], N_b + 1, 0.0);
+      std::fill_n(mem.I_i()[0], N_b + 1, 0);
+      std::fill_n(mem.I_j()[0], N_b + 1, 0);
+
+      // the band of the previous row: alive from lo to hi, computed up to last
+      boost::uint32_t lo = 1, hi = N_b, last = N_b;
+
+      for (boost::uint32_t i = 1; i <= N_a; i++) {
+        if (lo > hi) {
+          // no cell of the previous row is within X of the maximum
+          skipped += static_cast<boost::uint64_t>(N_a - i + 1) * N_b;
+          break;
+        }
 
-    for (boost::uint32_t i = 1; i <= N_a; i++) {
-      for (boost::uint32_t j = 1; j <= N_b; j++) {
-        // calculate all possible paths to improve on prev optimal alignments
-        // we assume for 1 and 2 a linear gap scoring scheme. Hence we do not need to apply a max operator
-        //  over previous indices since we know that the max value is attained at the previous index
-        temp[0] = mem.H()[i-1][j-1] + scoring_matrix.d(seq_a[i-1], seq_b[j-1]);
-        temp[1] = mem.H()[i-1][j] - scoring_matrix.getDelta();
-        temp[2] = mem.H()[i][j-1] - scoring_matrix.getDelta();
-        temp[3] = 0.0;
-
-        // get max
-        mdit = std::max_element(temp, temp+4);
-        mem.H()[i][j] = *mdit;
-
-        switch (std::distance(temp, mdit)) {
-          case 0: // score in (i,j) stems from a match/mismatch
-            mem.I_i()[i][j] = i-1;
-            mem.I_j()[i][j] = j-1;
-            break;
-          case 1: // score in (i,j) stems from a del in sequence A
-            mem.I_i()[i][j] = i-1;
-            mem.I_j()[i][j] = j;
-            break;
-          case 2: // score in (i,j) stems from a del in sequence B
-            mem.I_i()[i][j] = i;
-            mem.I_j()[i][j] = j-1;
-            break;
-          case 3: // (i,j) is the beginning of a subsequence
-            mem.I_i()[i][j] = i;
-            mem.I_j()[i][j] = j;
+        typename Scorer::Row d = score.row(i-1);
+        boost::uint32_t next_lo = 1, next_hi = 0;
+
+        // the cell left of the band, column 0 included, has not been computed and starts subsequences
+        start(mem, i, lo - 1);
+
+        boost::uint32_t j = lo;
+        for (; j <= N_b; j++) {
+          if (j > last) {
+            start(mem, i-1, j);
+          }
+          cell(mem, d, i, j, scoring_matrix.getDelta(), H_max, i_max, j_max);
+
+          if (mem.H()[i][j] + m_xdrop >= H_max) {
+            if (next_lo > next_hi) {
+              next_lo = j;
+            }
+            next_hi = j;
+          } else if (j > hi) {
+            // neither the previous row nor this row extend beyond this cell
             break;
+          }
         }
 
-        // store maximum
-        if(mem.H()[i][j] > H_max){
-          H_max = mem.H()[i][j];
-          i_max = i;
-          j_max = j;
+        last = std::min(j, N_b);
+        skipped += (lo - 1) + (N_b - last);
+        lo = next_lo;
+        hi = next_hi;
+      }
+    } else {
+      // initialize H
+      mem.reset(N_a + 1, N_b + 1);
+
+      for (boost::uint32_t i = 1; i <= N_a; i++) {
+        typename Scorer::Row d = score.row(i-1);
+        for (boost::uint32_t j = 1; j <= N_b; j++) {
+          cell(mem, d, i, j, scoring_matrix.getDelta(), H_max, i_max, j_max);
         }
       }
     }
@@ -125,7 +228,7 @@ class SW : public SimilarityAlgorithm
     // store results
     alignmentResult result;
     result.score = H_max;
-    result.alignment.resize(2);
+    result.skipped = skipped;
 
 #ifndef NDEBUG
     std::cout << "H" << std::endl;
@@ -143,32 +246,67 @@ class SW : public SimilarityAlgorithm
       boost::int32_t current_i = i_max, current_j = j_max;
       boost::int32_t next_i = mem.I_i()[current_i][current_j];
       boost::int32_t next_j = mem.I_j()[current_i][current_j];
-      boost::int32_t tick = 0;
 
-      common::StringVec consensus_a, consensus_b;
-      consensus_a.resize(N_a + N_b + 2);
-      consensus_b.resize(N_a + N_b + 2);
+      TraceArena &arena = mem.trace();
+      arena.open(result.trace);
 
       while (((current_i != next_i) || (current_j != next_j)) && (next_j >= 0) && (next_i >= 0) && (current_i > 0) && (current_j > 0)) {
-        if (next_i == current_i) { consensus_a[tick] = "-"; } // deletion in A
-        else { consensus_a[tick] = scoring_matrix.match(seq_a[current_i-1], seq_b[current_j-1]); }      // match/mismatch in A
-
-        if (next_j == current_j) { consensus_b[tick] = "-"; } // deletion in B
-        else { consensus_b[tick] = scoring_matrix.match(seq_a[current_i-1], seq_b[current_j-1]); }      // match/mismatch in B
+        if (next_i == current_i) { arena.push(result.trace, TraceArena::INSERT); }       // deletion in A
+        else if (next_j == current_j) { arena.push(result.trace, TraceArena::DELETE); }  // deletion in B
+        else { arena.push(result.trace, TraceArena::MATCH); }                            // match/mismatch
 
         current_i = next_i;
         current_j = next_j;
         next_i = mem.I_i()[current_i][current_j];
         next_j = mem.I_j()[current_i][current_j];
-        tick++;
       }
 
-      for (boost::int32_t i = tick-1; i >= 0; i--) { result.alignment[0].push_back(consensus_a[i]); }
-      for (boost::int32_t j = tick-1; j >= 0; j--) { result.alignment[1].push_back(consensus_b[j]); }
+      arena.close(result.trace);
+      result.trace.begin_i = current_i;
+      result.trace.begin_j = current_j;
+      result.trace.end_i = i_max;
+      result.trace.end_j = j_max;
     }
 
     return result;
   } // sw
+
+  /** @fn alignmentResult linear(common::StringVec &seq_a, common::StringVec &seq_b, const Scorer &score, const AbstractDistanceMeasure &scoring_matrix, MemoryPool &mem)
+   * Compute the score of a pair exceeding the cap of the memory pool
+   * from two rows of H, without the X-drop and without traceback.
+   */
+  template <typename Scorer>
+  alignmentResult linear(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      const Scorer & score,     /* scores of the cells */
+      const AbstractDistanceMeasure & scoring_matrix,
+      MemoryPool &mem) {
+
+    boost::uint32_t N_a = seq_a.size();
+    boost::uint32_t N_b = seq_b.size();
+    double delta = scoring_matrix.getDelta();
+
+    mem.reset(2, N_b + 1);
+
+    double H_max = 0.;
+    for (boost::uint32_t i = 1; i <= N_a; i++) {
+      typename Scorer::Row d = score.row(i-1);
+      const double *prev = mem.H()[(i-1) & 1];
+      double *cur = mem.H()[i & 1];
+
+      for (boost::uint32_t j = 1; j <= N_b; j++) {
+        cur[j] = std::max(std::max(prev[j-1] + d(j-1), prev[j] - delta), std::max(cur[j-1] - delta, 0.0));
+        H_max = std::max(H_max, cur[j]);
+      }
+    }
+
+    alignmentResult result;
+    result.score = H_max;
+    result.capped = true;
+
+    return result;
+  }
 };
 
 
@@ -31,20 +31,31 @@
 #endif /* __STDC_CONSTANT_MACROS */
 
 
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
 #include "Types.hh"
 #include "AbstractDistanceMeasure.hh"
 #include "MemoryPool.hh"
+#include "Profile.hh"
+#include "Trace.hh"
 
 namespace alignment
 {
 
 
 /** @struct alignmentResult
- * This structure keeps the result of an alignment, containing the score and a vector of alignments.
+ * This structure keeps the result of an alignment, containing the score and the
+ * traceback in the trace arena of the memory pool, if the alignment was computed.
  */
 struct alignmentResult {
   double score;
-  std::vector<common::StringVec> alignment;
+  trace_t trace;
+  boost::uint64_t skipped;  /* cells of the matrix skipped by the X-drop */
+  bool capped;              /* the matrices exceeded the cap, the score was computed without traceback */
+
+  alignmentResult() : score(0.0), skipped(0), capped(false) {}
 };
 
 
@@ -59,7 +70,7 @@ class SimilarityAlgorithm
   SimilarityAlgorithm() {}
   virtual ~SimilarityAlgorithm() {}
 
-  /** @fn alignmentResult align(std::vector<boost::flyweight<std::string> >, std::vector<boost::flyweight<std::string> >, AbstractDistanceMeasure &, MemoryPool &)
+  /** @fn alignmentResult align(std::vector<boost::flyweight<std::string> >, std::vector<boost::flyweight<std::string> >, const AbstractDistanceMeasure &, MemoryPool &)
    *
    * This function computes similarities between two sequences and given a scoring scheme. The
    * concrete implementation needs to implement this definition in order to comply with this
@@ -67,11 +78,28 @@ class SimilarityAlgorithm
    *
    * @param common::StringVec & the first sequence
    * @param common::StringVec & the second sequence
-   * @param AbstractDistanceMeasure & the scoring scheme
+   * @param const AbstractDistanceMeasure & the scoring scheme
+   * @param MemoryPool & external memory holding the dynamic programming matrices
+   */
+  virtual alignmentResult align(common::StringVec & seq_a, common::StringVec & seq_b,
+                                const AbstractDistanceMeasure & scoring_matrix,
+                                MemoryPool & mem) = 0;
+
+  /** @fn alignmentResult align(common::StringVec &, common::StringVec &, const Profile &, const std::vector<boost::uint32_t> &, const AbstractDistanceMeasure &, MemoryPool &)
+   *
+   * This function computes the same similarity, but scores the cells by
+   * the profile of the first sequence.
+   *
+   * @param common::StringVec & the first sequence
+   * @param common::StringVec & the second sequence
+   * @param const Profile & the profile of the first sequence
+   * @param const std::vector<boost::uint32_t> & the second sequence encoded as indices into the alphabet of the profile
+   * @param const AbstractDistanceMeasure & the scoring scheme
    * @param MemoryPool & external memory holding the dynamic programming matrices
    */
   virtual alignmentResult align(common::StringVec & seq_a, common::StringVec & seq_b,
-                                AbstractDistanceMeasure & scoring_matrix,
+                                const Profile & profile, const std::vector<boost::uint32_t> & cols_b,
+                                const AbstractDistanceMeasure & scoring_matrix,
                                 MemoryPool & mem) = 0;
 };
 
@@ -0,0 +1,191 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Sweep.hh
+ * Declaration and implementation of the alignment scores of several gap penalties in one pass.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __SWEEP_HH__
+#define __SWEEP_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "AbstractDistanceMeasure.hh"
+#include "MemoryPool.hh"
+#include "Profile.hh"
+#include "Types.hh"
+
+
+namespace alignment
+{
+
+
+/** @struct lane_t
+ * structure specifying one of the alignments scored together by a sweep.
+ */
+struct lane_t {
+  bool local;     /* local (Smith-Waterman) or global (Needleman-Wunsch) alignment */
+  double delta;   /* gap penalty */
+
+  lane_t(bool p_local, double p_delta) : local(p_local), delta(p_delta) {}
+};
+
+
+/** @class Sweep
+ *
+ * This class computes the scores of a pair of sequences for several
+ * alignments at once, e.g., the same alignment with different gap
+ * penalties. The cells of all lanes are kept next to each other in two
+ * rows of H, so that the score of the symbols of a cell is looked up
+ * once for all lanes and the innermost loop over the lanes is free of
+ * branches. The scores are identical to the ones of SW and NW with the
+ * gap penalty of the lane. No tracebacks are computed.
+ */
+class Sweep
+{
+ public:
+  Sweep(const std::vector<lane_t> &p_lanes)
+      : m_lanes(p_lanes)
+  {
+    for (std::vector<lane_t>::const_iterator it = m_lanes.begin(); it != m_lanes.end(); ++it) {
+      m_delta.push_back(it->delta);
+      // the local alignments restart at 0, the global ones never do
+      m_floor.push_back(it->local ? 0.0 : -std::numeric_limits<double>::infinity());
+    }
+  }
+  ~Sweep() {}
+
+  /** @return the number of lanes */
+  boost::uint32_t lanes() const
+  {
+    return m_lanes.size();
+  }
+
+  const lane_t & lane(boost::uint32_t k) const
+  {
+    return m_lanes[k];
+  }
+
+  /** @fn void align(common::StringVec &seq_a, common::StringVec &seq_b, const AbstractDistanceMeasure &scoring_matrix, MemoryPool &mem, double *scores) const
+   * Compute the scores of all lanes, looking the cells up in the scoring scheme.
+   *
+   * @param double * the scores of the lanes
+   */
+  void align(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      const AbstractDistanceMeasure & scoring_matrix,
+      MemoryPool &mem,
+      double *scores) const {
+    run(seq_a, seq_b, SchemeScorer(scoring_matrix, seq_a, seq_b), mem, scores);
+  }
+
+  /** @fn void align(common::StringVec &seq_a, common::StringVec &seq_b, const Profile &profile, const std::vector<boost::uint32_t> &cols_b, MemoryPool &mem, double *scores) const
+   * Compute the scores of all lanes, gathering the cells from the profile of the first sequence.
+   *
+   * @param double * the scores of the lanes
+   */
+  void align(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      const Profile & profile,
+      const std::vector<boost::uint32_t> & cols_b,
+      MemoryPool &mem,
+      double *scores) const {
+    run(seq_a, seq_b, ProfileScorer(profile, cols_b), mem, scores);
+  }
+
+ private:
+  template <typename Scorer>
+  void run(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      const Scorer & score,     /* scores of the cells */
+      MemoryPool &mem,
+      double *scores) const {
+
+    boost::uint32_t N_a = seq_a.size();
+    boost::uint32_t N_b = seq_b.size();
+    boost::uint32_t K = m_lanes.size();
+    const double *delta = &m_delta[0];
+    const double *floor = &m_floor[0];
+
+    // rows 0 and 1 alternate as the previous and the current row of
+    // all lanes, row 2 keeps the maximum of every lane
+    mem.reset(3, (N_b + 1) * K);
+    double *H_max = mem.H()[2];
+
+    double *border = mem.H()[0];
+    for (boost::uint32_t j = 1; j <= N_b; ++j) {
+      for (boost::uint32_t k = 0; k < K; ++k) {
+        border[j * K + k] = m_lanes[k].local ? 0.0 : -static_cast<double>(j) * delta[k];
+      }
+    }
+
+    for (boost::uint32_t i = 1; i <= N_a; i++) {
+      typename Scorer::Row d = score.row(i-1);
+      const double *prev = mem.H()[(i-1) & 1];
+      double *cur = mem.H()[i & 1];
+
+      for (boost::uint32_t k = 0; k < K; ++k) {
+        cur[k] = m_lanes[k].local ? 0.0 : -static_cast<double>(i) * delta[k];
+      }
+
+      for (boost::uint32_t j = 1; j <= N_b; j++) {
+        // the symbols of the cell are scored once for all lanes
+        double s = d(j-1);
+        const double *diag = prev + (j - 1) * K;
+        const double *up = prev + j * K;
+        const double *left = cur + (j - 1) * K;
+        double *H = cur + j * K;
+
+        for (boost::uint32_t k = 0; k < K; ++k) {
+          double h = std::max(std::max(diag[k] + s, up[k] - delta[k]), std::max(left[k] - delta[k], floor[k]));
+          H[k] = h;
+          H_max[k] = std::max(H_max[k], h);
+        }
+      }
+    }
+
+    const double *last = mem.H()[N_a & 1] + N_b * K;
+    for (boost::uint32_t k = 0; k < K; ++k) {
+      scores[k] = m_lanes[k].local ? H_max[k] : last[k];
+    }
+  }
+
+  std::vector<lane_t> m_lanes;
+  std::vector<double> m_delta;
+  std::vector<double> m_floor;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,173 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Trace.hh
+ * Declaration and implementation of the arena keeping the tracebacks of alignments.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __TRACE_HH__
+#define __TRACE_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "AbstractDistanceMeasure.hh"
+#include "Types.hh"
+
+
+namespace alignment
+{
+
+
+/** @struct trace_t
+ * structure referring to the traceback of an alignment in a trace arena.
+ */
+struct trace_t {
+  boost::uint32_t begin_i;        /* number of symbols of sequence 1 before the alignment */
+  boost::uint32_t begin_j;        /* number of symbols of sequence 2 before the alignment */
+  boost::uint32_t end_i;          /* number of symbols of sequence 1 up to the end of the alignment */
+  boost::uint32_t end_j;          /* number of symbols of sequence 2 up to the end of the alignment */
+  boost::uint32_t offset;         /* first operation in the arena */
+  boost::uint32_t length;         /* number of run-length encoded operations */
+
+  trace_t() : begin_i(0), begin_j(0), end_i(0), end_j(0), offset(0), length(0) {}
+};
+
+
+/** @class TraceArena
+ *
+ * This class keeps the tracebacks of alignments as run-length encoded
+ * operations, in the manner of a CIGAR string: the low two bits of an
+ * entry hold the operation and the remaining bits the length of the
+ * run. The consensus of an aligned column is the LCA of its symbols,
+ * which is a function of the positions, so the symbols are only
+ * materialised on demand. The arena is reset by its owner, which
+ * invalidates all traces referring to it.
+ */
+class TraceArena
+{
+ public:
+  /** operations of a column: both symbols, the symbol of sequence 2 only, the symbol of sequence 1 only */
+  enum op_t { MATCH = 0, INSERT = 1, DELETE = 2 };
+
+  TraceArena() {}
+
+  void reset()
+  {
+    m_ops.clear();
+  }
+
+  /** @fn void open(trace_t &p_trace)
+   * Start a trace; the operations are pushed from the end of the alignment to its beginning.
+   */
+  void open(trace_t &p_trace)
+  {
+    p_trace.offset = m_ops.size();
+    p_trace.length = 0;
+  }
+
+  void push(trace_t &p_trace, op_t p_op)
+  {
+    if (m_ops.size() > p_trace.offset && static_cast<op_t>(m_ops.back() & 3) == p_op) {
+      m_ops.back() += 4;
+    } else {
+      m_ops.push_back(4 | p_op);
+    }
+  }
+
+  /** @fn void close(trace_t &p_trace)
+   * Finish a trace by putting its operations into the order of the alignment.
+   */
+  void close(trace_t &p_trace)
+  {
+    std::reverse(m_ops.begin() + p_trace.offset, m_ops.end());
+    p_trace.length = m_ops.size() - p_trace.offset;
+  }
+
+  /** @return the operation of the k-th run of a trace */
+  op_t op(const trace_t &p_trace, boost::uint32_t k) const
+  {
+    return static_cast<op_t>(m_ops[p_trace.offset + k] & 3);
+  }
+
+  /** @return the length of the k-th run of a trace */
+  boost::uint32_t count(const trace_t &p_trace, boost::uint32_t k) const
+  {
+    return m_ops[p_trace.offset + k] >> 2;
+  }
+
+  /** @return the CIGAR string of a trace, e.g. 3M1I2M */
+  std::string cigar(const trace_t &p_trace) const
+  {
+    static const char OPS[] = { 'M', 'I', 'D' };
+    std::ostringstream os;
+    for (boost::uint32_t k = 0; k < p_trace.length; ++k) {
+      os << count(p_trace, k) << OPS[op(p_trace, k)];
+    }
+    return os.str();
+  }
+
+  /** @fn void materialise(const trace_t &p_trace, const common::StringVec &seq_a, const common::StringVec &seq_b, const AbstractDistanceMeasure &scoring_matrix, common::StringVec &p_a, common::StringVec &p_b) const
+   * Expand a trace into the consensus of both sequences. A column
+   * consuming a symbol of a sequence holds the match of the current
+   * symbols of both sequences (the symbol itself at the border of the
+   * matrix), the other sequence holds a gap "-".
+   */
+  void materialise(const trace_t &p_trace, const common::StringVec &seq_a, const common::StringVec &seq_b,
+                   const AbstractDistanceMeasure &scoring_matrix, common::StringVec &p_a, common::StringVec &p_b) const
+  {
+    const common::Symbol gap("-");
+    boost::uint32_t i = p_trace.begin_i, j = p_trace.begin_j;
+
+    p_a.clear();
+    p_b.clear();
+
+    for (boost::uint32_t k = 0; k < p_trace.length; ++k) {
+      op_t o = op(p_trace, k);
+      for (boost::uint32_t n = count(p_trace, k); n > 0; --n) {
+        if (o != INSERT) { i++; }
+        if (o != DELETE) { j++; }
+
+        common::Symbol consensus = (i == 0) ? seq_b[j-1]
+            : (j == 0) ? seq_a[i-1] : scoring_matrix.match(seq_a[i-1], seq_b[j-1]);
+        p_a.push_back((o == INSERT) ? gap : consensus);
+        p_b.push_back((o == DELETE) ? gap : consensus);
+      }
+    }
+  }
+
+ private:
+  std::vector<boost::uint32_t> m_ops;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,217 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Wavefront.hh
+ * Declaration and implementation of the score of a single pair computed by several threads.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __WAVEFRONT_HH__
+#define __WAVEFRONT_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "AbstractDistanceMeasure.hh"
+#include "Profile.hh"
+#include "Types.hh"
+
+
+namespace alignment
+{
+
+
+/** @class Wavefront
+ *
+ * This class computes the score of a single pair by several threads.
+ * The matrix is cut into square tiles, and the rows of tiles are dealt
+ * out to the threads round-robin. A thread computes the tiles of its
+ * rows from left to right, each after the tile above it, so that the
+ * threads sweep the anti-diagonals of tiles in a pipelined wavefront.
+ * The number of completed tiles of every row of tiles is an atomic
+ * counter, which the thread of the row below waits for. The tiles
+ * exchange their last rows through a row of the width of the matrix,
+ * their last columns through a column of its height (only read by the
+ * same thread) and their bottom right cells, which the tile below right
+ * starts from. The scores are identical to the ones of SW and NW. No
+ * tracebacks are computed.
+ *
+ * reset() is called by a single thread, then align() by all threads
+ * with their own number, and score() once all of them have returned.
+ */
+class Wavefront : boost::noncopyable
+{
+ public:
+  Wavefront(bool p_local, double p_delta, boost::uint32_t p_tile)
+      : m_local(p_local), m_delta(p_delta), m_tile(std::max<boost::uint32_t>(p_tile, 1)),
+        m_floor(p_local ? 0.0 : -std::numeric_limits<double>::infinity()),
+        m_N_a(0), m_N_b(0), m_rows(0), m_cols(0)
+  {}
+  ~Wavefront() {}
+
+  /** @fn void reset(boost::uint32_t N_a, boost::uint32_t N_b, boost::uint32_t threads)
+   * Prepare the tiles of a pair of the given lengths for the given number of threads.
+   */
+  void reset(boost::uint32_t N_a, boost::uint32_t N_b, boost::uint32_t threads)
+  {
+    m_N_a = N_a;
+    m_N_b = N_b;
+    m_rows = (N_a + m_tile - 1) / m_tile;
+    m_cols = (N_b + m_tile - 1) / m_tile;
+
+    // the last row of the tiles starts as the first row of the matrix
+    m_last.resize(N_b + 1);
+    for (boost::uint32_t j = 0; j <= N_b; ++j) {
+      m_last[j] = border(j);
+    }
+    m_right.resize(N_a + 1);
+    m_corners.resize(static_cast<std::size_t>(m_rows) * m_cols);
+    m_max.assign(std::max<boost::uint32_t>(threads, 1), 0.0);
+
+    m_done.reset(new std::atomic<boost::uint32_t>[m_rows]);
+    for (boost::uint32_t r = 0; r < m_rows; ++r) {
+      m_done[r].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /** @fn void align(common::StringVec &seq_a, common::StringVec &seq_b, const AbstractDistanceMeasure &scoring_matrix, boost::uint32_t thread, boost::uint32_t threads)
+   * Compute the rows of tiles of a thread, looking the cells up in the scoring scheme.
+   */
+  void align(
+      common::StringVec &seq_a, /* sequence 1 */
+      common::StringVec &seq_b, /* sequence 2 */
+      const AbstractDistanceMeasure & scoring_matrix,
+      boost::uint32_t thread,
+      boost::uint32_t threads) {
+    run(SchemeScorer(scoring_matrix, seq_a, seq_b), thread, threads);
+  }
+
+  /** @fn void align(const Profile &profile, const std::vector<boost::uint32_t> &cols_b, boost::uint32_t thread, boost::uint32_t threads)
+   * Compute the rows of tiles of a thread, gathering the cells from the profile of the first sequence.
+   */
+  void align(
+      const Profile & profile,
+      const std::vector<boost::uint32_t> & cols_b,
+      boost::uint32_t thread,
+      boost::uint32_t threads) {
+    run(ProfileScorer(profile, cols_b), thread, threads);
+  }
+
+  /** @return the score of the pair */
+  double score() const
+  {
+    return m_local ? *std::max_element(m_max.begin(), m_max.end()) : m_last[m_N_b];
+  }
+
+ private:
+  /** @return the cell of the first row or column at the given index */
+  double border(boost::uint32_t p_k) const
+  {
+    return m_local ? 0.0 : -static_cast<boost::int32_t>(p_k) * m_delta;
+  }
+
+  template <typename Scorer>
+  void run(const Scorer & score, boost::uint32_t thread, boost::uint32_t threads) {
+    std::vector<double> rows[2] = { std::vector<double>(m_tile + 1), std::vector<double>(m_tile + 1) };
+    double H_max = 0.0;
+
+    for (boost::uint32_t r = thread; r < m_rows; r += threads) {
+      boost::uint32_t i_0 = r * m_tile + 1;
+      boost::uint32_t i_1 = std::min(i_0 + m_tile - 1, m_N_a);
+
+      for (boost::uint32_t c = 0; c < m_cols; ++c) {
+        boost::uint32_t j_0 = c * m_tile + 1;
+        boost::uint32_t j_1 = std::min(j_0 + m_tile - 1, m_N_b);
+        boost::uint32_t width = j_1 - j_0 + 1;
+
+        // the tile above has to be complete
+        if (r > 0) {
+          while (m_done[r - 1].load(std::memory_order_acquire) <= c) {
+            std::this_thread::yield();
+          }
+        }
+
+        // the row above the tile, starting with the cell above left of it
+        double *up = &rows[0][0];
+        if (r == 0) {
+          up[0] = border(j_0 - 1);
+        } else if (c == 0) {
+          up[0] = border(i_0 - 1);
+        } else {
+          up[0] = m_corners[static_cast<std::size_t>(r - 1) * m_cols + c - 1];
+        }
+        std::copy(&m_last[j_0], &m_last[j_0] + width, up + 1);
+
+        for (boost::uint32_t i = i_0; i <= i_1; ++i) {
+          typename Scorer::Row d = score.row(i-1);
+          double *cur = &rows[(i - i_0 + 1) & 1][0];
+          const double *prev = &rows[(i - i_0) & 1][0];
+
+          cur[0] = (c == 0) ? border(i) : m_right[i];
+          for (boost::uint32_t k = 1; k <= width; ++k) {
+            boost::uint32_t j = j_0 + k - 1;
+            cur[k] = std::max(std::max(prev[k-1] + d(j-1), prev[k] - m_delta), std::max(cur[k-1] - m_delta, m_floor));
+            H_max = std::max(H_max, cur[k]);
+          }
+          m_right[i] = cur[width];
+        }
+
+        const double *bottom = &rows[(i_1 - i_0 + 1) & 1][0];
+        std::copy(bottom + 1, bottom + width + 1, &m_last[j_0]);
+        m_corners[static_cast<std::size_t>(r) * m_cols + c] = bottom[width];
+
+        m_done[r].store(c + 1, std::memory_order_release);
+      }
+    }
+
+    m_max[thread] = H_max;
+  }
+
+  bool m_local;
+  double m_delta;
+  boost::uint32_t m_tile;
+  double m_floor;
+  boost::uint32_t m_N_a;
+  boost::uint32_t m_N_b;
+  boost::uint32_t m_rows;
+  boost::uint32_t m_cols;
+  std::vector<double> m_last;
+  std::vector<double> m_right;
+  std::vector<double> m_corners;
+  std::vector<double> m_max;
+  std::unique_ptr<std::atomic<boost::uint32_t>[]> m_done;
+};
+
+
+}
+
+
+#endif
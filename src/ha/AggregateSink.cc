@@ -0,0 +1,179 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file AggregateSink.cc
+ * Implementation of the aggregates of the scores of every query position.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef _OPENMP
+# include <omp.h>
+#endif /* _OPENMP */
+
+#include "AggregateSink.hh"
+
+
+namespace ha
+{
+
+
+/* the number of unique targets worth sharing a row among the threads */
+static const boost::uint32_t PARALLEL_TARGETS = 4096;
+
+
+void AggregateSink::write(boost::uint32_t p_pos, SequenceSet &p_targets, const std::vector<double> &p_scores)
+{
+  if (m_next != NULL) {
+    m_next->write(p_pos, p_targets, p_scores);
+  }
+
+  index(p_targets);
+  boost::uint32_t unique = p_targets.uniqueSize();
+  boost::uint32_t threads = 1;
+
+  #pragma omp parallel if (unique >= PARALLEL_TARGETS) shared(p_scores, unique, threads) default(none)
+  {
+#ifdef _OPENMP
+    boost::uint32_t thread = omp_get_thread_num();
+    #pragma omp single nowait
+    {
+      threads = omp_get_num_threads();
+    }
+#else
+    boost::uint32_t thread = 0;
+#endif /* _OPENMP */
+    summary_t &local = m_partial[thread];
+    reset(local);
+
+    #pragma omp for schedule(static)
+    for (boost::uint32_t v = 0; v < unique; ++v) {
+      add(local, v, p_scores[v]);
+    }
+  }
+
+  // the reducers are merged in the order of the threads, so that the sums do not depend on the timing
+  summary_t &total = m_partial[0];
+  for (boost::uint32_t t = 1; t < threads; ++t) {
+    merge(total, m_partial[t]);
+  }
+
+  if (total.count == 0) {
+    m_out << std::numeric_limits<double>::quiet_NaN() << "\t-1\t" << std::numeric_limits<double>::quiet_NaN();
+  } else {
+    m_out << total.max << "\t" << total.argmax << "\t" << total.sum / total.count;
+  }
+  for (std::vector<boost::uint64_t>::const_iterator it = total.above.begin(); it != total.above.end(); ++it) {
+    m_out << "\t" << *it;
+  }
+  for (std::vector<boost::uint64_t>::const_iterator it = total.bins.begin(); it != total.bins.end(); ++it) {
+    m_out << "\t" << *it;
+  }
+  m_out << std::endl;
+}
+
+
+void AggregateSink::index(SequenceSet &p_targets)
+{
+  if (m_targets == &p_targets && m_first.size() == p_targets.uniqueSize()) {
+    return;
+  }
+  m_targets = &p_targets;
+
+  // the positions are visited backwards, so that the first position of a unique target is kept
+  m_first.assign(p_targets.uniqueSize(), 0);
+  for (std::size_t j = p_targets.size(); j-- > 0; ) {
+    m_first[p_targets.id(j)] = j;
+  }
+
+#ifdef _OPENMP
+  m_partial.resize(std::max(omp_get_max_threads(), 1));
+#else
+  m_partial.resize(1);
+#endif /* _OPENMP */
+}
+
+
+void AggregateSink::reset(summary_t &p_summary) const
+{
+  p_summary.max = -std::numeric_limits<double>::infinity();
+  p_summary.argmax = 0;
+  p_summary.sum = 0.0;
+  p_summary.count = 0;
+  p_summary.above.assign(m_thresholds.size(), 0);
+  p_summary.bins.assign(m_bins, 0);
+}
+
+
+void AggregateSink::add(summary_t &p_summary, boost::uint32_t p_v, double p_score) const
+{
+  boost::uint32_t multiplicity = m_targets->multiplicity(p_v);
+
+  if (p_summary.count == 0 || p_score > p_summary.max || (p_score == p_summary.max && m_first[p_v] < p_summary.argmax)) {
+    p_summary.max = p_score;
+    p_summary.argmax = m_first[p_v];
+  }
+  p_summary.sum += p_score * multiplicity;
+  p_summary.count += multiplicity;
+
+  for (std::size_t t = 0; t < m_thresholds.size(); ++t) {
+    if (p_score >= m_thresholds[t]) {
+      p_summary.above[t] += multiplicity;
+    }
+  }
+
+  // the scores outside the range count into the first or the last bin
+  double bin = std::floor((p_score - m_min) / (m_max - m_min) * m_bins);
+  bin = (bin >= 0.0) ? std::min<double>(bin, m_bins - 1) : 0.0;
+  p_summary.bins[static_cast<boost::uint32_t>(bin)] += multiplicity;
+}
+
+
+void AggregateSink::merge(summary_t &p_summary, const summary_t &p_other) const
+{
+  if (p_other.count == 0) {
+    return;
+  }
+
+  if (p_summary.count == 0 || p_other.max > p_summary.max
+      || (p_other.max == p_summary.max && p_other.argmax < p_summary.argmax)) {
+    p_summary.max = p_other.max;
+    p_summary.argmax = p_other.argmax;
+  }
+  p_summary.sum += p_other.sum;
+  p_summary.count += p_other.count;
+
+  for (std::size_t t = 0; t < p_summary.above.size(); ++t) {
+    p_summary.above[t] += p_other.above[t];
+  }
+  for (std::size_t b = 0; b < p_summary.bins.size(); ++b) {
+    p_summary.bins[b] += p_other.bins[b];
+  }
+}
+
+
+}
@@ -0,0 +1,1084 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Aligner.cc
+ * Implementation of the batch alignment of sets of sequences.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#ifndef NDEBUG
+# include <iterator>
+#endif /* NDEBUG */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <utility>
+
+#ifdef _OPENMP
+# include <omp.h>
+#endif /* _OPENMP */
+
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Frontier.hh"
+#include "NW.hh"
+#include "Profile.hh"
+#include "RLE.hh"
+#include "SW.hh"
+
+#include "Aligner.hh"
+#include "LevelTreePathSimilarityMeasure.hh"
+#include "Normaliser.hh"
+#include "SeedIndex.hh"
+#include "TreePathSimilarityMeasure.hh"
+
+
+namespace ha
+{
+
+
+/** @struct Aligner::replica_t
+ * structure holding the data read by the workers of a NUMA node. The
+ * replica either refers to the shared scoring scheme and targets or to
+ * copies first touched by a worker on the node.
+ */
+struct Aligner::replica_t {
+  const TreePathSimilarityMeasure *scheme;                              /* scoring scheme */
+  common::Sequences *unique_2;                                          /* unique target sequences */
+  std::vector<std::vector<boost::uint32_t> > *cols;                     /* targets encoded as indices into the alphabet */
+  alignment::Profile profile;                                           /* profile of the query of the current row */
+  boost::scoped_ptr<TreePathSimilarityMeasure> localScheme;             /* node-local copy of the scoring scheme */
+  common::Sequences localUnique_2;                                      /* node-local copy of the unique targets */
+  std::vector<std::vector<boost::uint32_t> > localCols;                 /* node-local copy of the encoded targets */
+};
+
+
+/** @struct Aligner::targets_t
+ * structure holding the indexed targets shared by all batches against them.
+ */
+struct Aligner::targets_t {
+  SequenceSet *set;                                                     /* target sequences */
+  common::Sequences coarse;                                             /* coarse target sequences */
+  std::vector<double> self;                                             /* self-alignment scores of the targets */
+  common::StringVec alphabet;                                           /* symbols used by the targets */
+  std::vector<std::vector<boost::uint32_t> > cols;                      /* targets encoded as indices into the alphabet */
+  std::vector<std::vector<boost::uint32_t> > ids;                       /* targets encoded as symbol IDs of the scheme */
+  std::vector<MinHash::sketch_t> sketches;                              /* sketches of the targets, if approximated */
+  boost::scoped_ptr<SeedIndex> seeds;                                   /* seed index of the targets, if any */
+  boost::scoped_ptr<alignment::AbstractDistanceMeasure> coarseScheme;   /* scoring scheme of the coarse alignments */
+  boost::scoped_ptr<alignment::SimilarityAlgorithm> coarseSimilarity;   /* coarse alignment algorithm, if any */
+  std::vector<boost::shared_ptr<replica_t> > replicas;                  /* replicas read by the workers, one per node */
+};
+
+
+/** @struct Aligner::batch_t
+ * structure holding the data shared by the workers aligning a row of unique sequences.
+ */
+struct Aligner::batch_t {
+  common::Sequences *unique_1;                                          /* unique query sequences */
+  common::Sequences *unique_2;                                          /* unique target sequences */
+  common::Sequences coarse_1;                                           /* coarse query sequences */
+  std::vector<double> self_1;                                           /* self-alignment scores of the queries */
+  std::vector<std::vector<boost::uint32_t> > ids_1;                     /* queries encoded as symbol IDs of the scheme */
+  std::vector<MinHash::sketch_t> sketches_1;                            /* sketches of the queries, if approximated */
+  double slope;                                                         /* approximate score per unit of sketch similarity */
+  double intercept;                                                     /* approximate score of dissimilar sketches */
+  targets_t *targets;                                                   /* indexed targets */
+
+  batch_t() : unique_1(NULL), unique_2(NULL), slope(1.0), intercept(0.0), targets(NULL) {}
+};
+
+
+Aligner::Aligner(Hierarchy &p_hierarchy, const alignOptions &p_options)
+    : m_hierarchy(p_hierarchy), m_options(p_options),
+      m_scoringScheme(createScheme(p_hierarchy, p_options)),
+      m_similarity(algorithm(p_options.scores, p_options.xdrop)), m_traceSink(NULL)
+{
+  init();
+}
+
+
+Aligner::Aligner(Hierarchy &p_hierarchy, const alignOptions &p_options,
+                 const boost::shared_ptr<const TreePathSimilarityMeasure> &p_scheme)
+    : m_hierarchy(p_hierarchy), m_options(p_options),
+      m_scoringScheme(p_scheme),
+      m_similarity(algorithm(p_options.scores, p_options.xdrop)), m_traceSink(NULL)
+{
+  init();
+}
+
+
+boost::shared_ptr<const TreePathSimilarityMeasure> Aligner::createScheme(Hierarchy &p_hierarchy, const alignOptions &p_options)
+{
+  // the pages apply to the score table and the matrices allocated from now on
+  alignment::pagePolicy() = static_cast<alignment::pages_t>(p_options.huge_pages);
+  return boost::shared_ptr<const TreePathSimilarityMeasure>(
+      new TreePathSimilarityMeasure(p_options.gap_penalty, p_hierarchy.levels(), p_hierarchy.positions(), p_hierarchy.lcas()));
+}
+
+
+void Aligner::init()
+{
+  // the lanes of a sweep score the configured algorithm with every gap penalty,
+  // the joint algorithm the local alignments first and then the global ones
+  if (!m_options.sweep.empty() || m_options.alg == 3) {
+    std::vector<double> penalties(m_options.sweep);
+    if (penalties.empty()) {
+      penalties.push_back(m_options.gap_penalty);
+    }
+
+    std::vector<alignment::lane_t> lanes;
+    for (boost::int32_t alg = 1; alg <= 2; ++alg) {
+      if (m_options.alg == alg || m_options.alg == 3) {
+        for (std::vector<double>::const_iterator it = penalties.begin(); it != penalties.end(); ++it) {
+          lanes.push_back(alignment::lane_t(alg == 1, *it));
+        }
+      }
+    }
+    m_sweep.reset(new alignment::Sweep(lanes));
+  }
+
+  // the approximate scores compare sketches instead of aligning the pairs
+  if (m_options.alg == 4) {
+    m_minhash.reset(new MinHash(m_hierarchy.projection(), m_options.sketch_k, m_options.sketch_size));
+  }
+
+  if (m_options.numa && !m_topology.load()) {
+    std::cerr << "The NUMA topology is not available, the workers are not pinned." << std::endl;
+  }
+}
+
+
+Aligner::~Aligner()
+{}
+
+
+alignment::SimilarityAlgorithm * Aligner::algorithm(bool p_justscores, double p_xdrop) const
+{
+  // the X-drop only applies to the local alignments, all other kernels are exact.
+  // The single and coarse alignments of the joint algorithm are local
+  if (m_options.rle && p_justscores) {
+    return new alignment::RLE(m_options.alg != 2);
+  } else if (m_options.alg != 2) {
+    return new alignment::SW(p_justscores, p_xdrop);
+  } else {
+    return new alignment::NW(p_justscores);
+  }
+}
+
+
+void Aligner::reservePools()
+{
+#ifdef _OPENMP
+  m_pools.resize(std::max<std::size_t>(m_pools.size(), omp_get_max_threads()));
+#else
+  m_pools.resize(1);
+#endif /* _OPENMP */
+
+  for (std::vector<alignment::MemoryPool>::iterator it = m_pools.begin(); it != m_pools.end(); ++it) {
+    it->cap(m_options.dp_cap);
+  }
+}
+
+
+boost::uint32_t Aligner::worker() const
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif /* _OPENMP */
+}
+
+
+boost::uint32_t Aligner::workers() const
+{
+#ifdef _OPENMP
+  return omp_get_num_threads();
+#else
+  return 1;
+#endif /* _OPENMP */
+}
+
+
+alignment::MemoryPool & Aligner::pool()
+{
+  return m_pools[worker()];
+}
+
+
+void Aligner::place() const
+{
+  if (m_options.numa) {
+    m_topology.pin(worker());
+  }
+}
+
+
+bool Aligner::tiles(const alignment::MemoryPool &p_mem, boost::uint32_t p_a, boost::uint32_t p_b) const
+{
+  // the tiles only compute the score, so pairs with a traceback fitting the pool are not deferred
+  return (m_options.wavefront > 0) && !m_sweep && !m_minhash && !m_options.rle && m_options.xdrop == 0.0
+      && static_cast<boost::uint64_t>(p_a) * p_b >= m_options.wavefront
+      && (m_options.scores || !p_mem.fits(p_a + 1, p_b + 1));
+}
+
+
+void Aligner::release() const
+{
+  // the calling thread was worker 0 of the placed region, the threads it
+  // starts later, e.g., those compressing the output, must not inherit its CPU
+  if (m_options.numa) {
+    m_topology.restore();
+  }
+}
+
+
+Aligner::replica_t & Aligner::replica()
+{
+  return *m_targets->replicas[worker() % m_targets->replicas.size()];
+}
+
+
+void Aligner::encode(common::Sequences &p_seqs, std::vector<std::vector<boost::uint32_t> > &p_ids) const
+{
+  p_ids.resize(p_seqs.size());
+  for (boost::uint32_t u = 0; u < p_seqs.size(); ++u) {
+    p_ids[u].resize(p_seqs[u].size());
+    for (boost::uint32_t k = 0; k < p_seqs[u].size(); ++k) {
+      p_ids[u][k] = m_scoringScheme->id(p_seqs[u][k]);
+    }
+  }
+}
+
+
+void Aligner::lcas(const alignment::trace_t &p_trace, const alignment::TraceArena &p_arena,
+                   const std::vector<boost::uint32_t> &p_a, const std::vector<boost::uint32_t> &p_b,
+                   std::vector<boost::uint32_t> &p_lcas) const
+{
+  boost::uint32_t i = p_trace.begin_i, j = p_trace.begin_j;
+
+  p_lcas.clear();
+  for (boost::uint32_t k = 0; k < p_trace.length; ++k) {
+    boost::uint32_t n = p_arena.count(p_trace, k);
+    switch (p_arena.op(p_trace, k)) {
+      case alignment::TraceArena::MATCH:
+        for (; n > 0; --n, ++i, ++j) {
+          p_lcas.push_back(m_scoringScheme->lca(p_a[i], p_b[j]));
+        }
+        break;
+      case alignment::TraceArena::INSERT:
+        j += n;
+        break;
+      case alignment::TraceArena::DELETE:
+        i += n;
+        break;
+    }
+  }
+}
+
+
+void Aligner::selfScores(common::Sequences &p_seqs, std::vector<double> &p_scores)
+{
+  boost::scoped_ptr<alignment::SimilarityAlgorithm> selfSimilarity(algorithm(true));
+  // the scores of the lanes of a sequence are next to each other
+  boost::uint32_t lanes = this->lanes();
+  p_scores.resize(p_seqs.size() * lanes);
+
+  #pragma omp parallel shared(p_seqs, p_scores, selfSimilarity, lanes) default(none)
+  {
+    place();
+    alignment::MemoryPool &mem = pool();
+
+    #pragma omp for
+    for (boost::uint32_t u = 0; u < p_seqs.size(); ++u) {
+      if (m_sweep) {
+        m_sweep->align(p_seqs[u], p_seqs[u], *m_scoringScheme, mem, &p_scores[u * lanes]);
+      } else {
+        p_scores[u] = selfSimilarity->align(p_seqs[u], p_seqs[u], *m_scoringScheme, mem).score;
+      }
+    }
+  }
+  release();
+}
+
+
+void Aligner::sketch(common::Sequences &p_seqs, std::vector<MinHash::sketch_t> &p_sketches)
+{
+  p_sketches.resize(p_seqs.size());
+
+  #pragma omp parallel shared(p_seqs, p_sketches) default(none)
+  {
+    place();
+
+    #pragma omp for schedule(dynamic, 64)
+    for (boost::uint32_t u = 0; u < p_seqs.size(); ++u) {
+      m_minhash->sketch(p_seqs[u], p_sketches[u]);
+    }
+  }
+  release();
+}
+
+
+template <typename Normaliser>
+void Aligner::calibrate(batch_t &p_batch)
+{
+  common::Sequences &unique_1 = *p_batch.unique_1;
+  common::Sequences &unique_2 = *p_batch.unique_2;
+  boost::uint64_t pairs = static_cast<boost::uint64_t>(unique_1.size()) * unique_2.size();
+  boost::uint32_t n = std::min<boost::uint64_t>(m_options.sketch_sample, pairs);
+
+  p_batch.slope = 1.0;
+  p_batch.intercept = 0.0;
+  if (n == 0) {
+    return;
+  }
+
+  // the sampled pairs are the same in every run over the same sets
+  std::mt19937_64 rng;
+  std::vector<std::pair<boost::uint32_t, boost::uint32_t> > sample(n);
+  for (boost::uint32_t s = 0; s < n; ++s) {
+    sample[s] = std::make_pair(rng() % unique_1.size(), rng() % unique_2.size());
+  }
+
+  std::vector<double> exact(n), approx(n);
+
+  #pragma omp parallel shared(p_batch, unique_1, unique_2, n, sample, exact, approx) default(none)
+  {
+    place();
+    alignment::MemoryPool &mem = pool();
+
+    #pragma omp for schedule(dynamic)
+    for (boost::uint32_t s = 0; s < n; ++s) {
+      common::StringVec &a = unique_1[sample[s].first];
+      common::StringVec &b = unique_2[sample[s].second];
+
+      double score = m_similarity->align(a, b, *m_scoringScheme, mem).score;
+      exact[s] = Normaliser::normalise(score, a.size(), b.size(),
+                                       Normaliser::SELF_SCORES ? m_similarity->align(a, a, *m_scoringScheme, mem).score : 0.0,
+                                       Normaliser::SELF_SCORES ? m_similarity->align(b, b, *m_scoringScheme, mem).score : 0.0);
+      approx[s] = m_minhash->similarity(p_batch.sketches_1[sample[s].first], p_batch.targets->sketches[sample[s].second]);
+    }
+  }
+  release();
+
+  // the least squares line through the even samples maps the sketch similarities onto the scores
+  double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0, m = 0.0;
+  for (boost::uint32_t s = 0; s < n; s += 2) {
+    sx += approx[s];
+    sy += exact[s];
+    sxx += approx[s] * approx[s];
+    sxy += approx[s] * exact[s];
+    m++;
+  }
+  double var = m * sxx - sx * sx;
+  p_batch.slope = (var > 0.0) ? (m * sxy - sx * sy) / var : 0.0;
+  p_batch.intercept = (sy - p_batch.slope * sx) / m;
+
+  // the errors are measured on the odd samples held out of the fit
+  std::vector<double> errors;
+  for (boost::uint32_t s = (n > 1) ? 1 : 0; s < n; s += 2) {
+    errors.push_back(std::fabs(p_batch.intercept + p_batch.slope * approx[s] - exact[s]));
+  }
+  std::sort(errors.begin(), errors.end());
+
+  double sum = 0.0, squares = 0.0;
+  for (std::vector<double>::iterator it = errors.begin(); it != errors.end(); ++it) {
+    sum += *it;
+    squares += *it * *it;
+  }
+  m_stats.sampledPairs = n;
+  m_stats.sampleMeanError = sum / errors.size();
+  m_stats.sampleRmsError = std::sqrt(squares / errors.size());
+  m_stats.sampleP95Error = errors[std::min<std::size_t>(errors.size() - 1, std::ceil(0.95 * errors.size()) - 1)];
+}
+
+
+template <typename Normaliser>
+boost::uint64_t Aligner::alignRow(batch_t &p_batch, boost::uint32_t p_u, std::vector<boost::uint32_t> &p_candidates,
+                                  std::vector<std::vector<double> > &p_rows)
+{
+  boost::uint64_t filtered = 0;
+  boost::uint64_t skipped = 0;
+  boost::uint64_t capped = 0;
+  boost::uint64_t approximated = 0;
+  common::Sequences &unique_1 = *p_batch.unique_1;
+  common::Sequences &unique_2 = *p_batch.unique_2;
+  boost::uint32_t replicas = p_batch.targets->replicas.size();
+  boost::uint32_t lanes = p_rows.size();
+  std::vector<double> &row = p_rows[0];
+
+  // the profile of the query replaces the lookups in the scoring scheme, if
+  // scoring the alphabet is cheaper than the lookups of a single column
+  boost::uint64_t length = 0;
+  for (boost::uint32_t c = 0; c < p_candidates.size(); ++c) {
+    length += unique_2[p_candidates[c]].size();
+  }
+  bool profiled = !m_minhash && p_batch.targets->alphabet.size() < length;
+
+  bool traced = (m_traceSink != NULL) && !m_options.scores;
+
+  // the pairs of more cells than the wavefront threshold are deferred to the
+  // end of the row and computed one by one by all workers together
+  std::vector<char> deferred(p_candidates.size(), 0);
+  alignment::Wavefront wavefront(m_options.alg != 2, m_options.gap_penalty, m_options.wavefront_tile);
+  boost::uint64_t tiledPairs = 0;
+
+  #pragma omp parallel shared(std::cout, p_batch, p_u, p_candidates, p_rows, row, filtered, skipped, capped, approximated, unique_1, unique_2, profiled, traced, replicas, lanes, deferred, wavefront, tiledPairs) default(none)
+  {
+    place();
+    alignment::MemoryPool &mem = pool();
+    replica_t &local = replica();
+    std::vector<boost::uint32_t> ids;
+    std::vector<double> scores(lanes);
+    // the tracebacks of a row are consumed before the next row
+    mem.trace().reset();
+
+    // the first worker of every replica builds its profile
+    if (profiled && worker() < replicas) {
+      local.profile.build(unique_1[p_u], p_batch.targets->alphabet, *local.scheme);
+    }
+    #pragma omp barrier
+
+    #pragma omp for reduction(+:filtered, skipped, capped, approximated)
+    for (boost::uint32_t c = 0; c < p_candidates.size(); ++c) {
+      boost::uint32_t j = p_candidates[c];
+
+      if (p_batch.targets->coarseSimilarity) {
+        alignment::alignmentResult coarse = p_batch.targets->coarseSimilarity->align(
+            p_batch.coarse_1[p_u], p_batch.targets->coarse[j], *p_batch.targets->coarseScheme, mem);
+        if (SquaredMinNormaliser::normalise(coarse.score, p_batch.coarse_1[p_u].size(), p_batch.targets->coarse[j].size(),
+                                            0.0, 0.0) < m_options.coarse_min) {
+          filtered++;
+          continue;
+        }
+      }
+#ifndef NDEBUG
+      std::cout << "i: ";
+      std::copy(unique_1[p_u].begin(), unique_1[p_u].end(), std::ostream_iterator<std::string>(std::cout, " "));
+      std::cout << std::endl;
+      std::cout << "j: ";
+      std::copy(unique_2[j].begin(), unique_2[j].end(), std::ostream_iterator<std::string>(std::cout, " "));
+      std::cout << std::endl;
+#endif /* NDEBUG */
+
+      common::StringVec &target = (*local.unique_2)[j];
+
+      if (tiles(mem, unique_1[p_u].size(), target.size())) {
+        deferred[c] = 1;
+        continue;
+      }
+
+      if (m_minhash) {
+        // the approximate score of a pair only compares the sketches
+        row[j] = p_batch.intercept + p_batch.slope * m_minhash->similarity(p_batch.sketches_1[p_u], p_batch.targets->sketches[j]);
+        approximated++;
+        continue;
+      }
+
+      if (m_sweep) {
+        // all lanes of the sweep are scored in a single pass over the matrix
+        if (profiled) {
+          m_sweep->align(unique_1[p_u], target, local.profile, (*local.cols)[j], mem, &scores[0]);
+        } else {
+          m_sweep->align(unique_1[p_u], target, *local.scheme, mem, &scores[0]);
+        }
+        for (boost::uint32_t k = 0; k < lanes; ++k) {
+          p_rows[k][j] = Normaliser::normalise(scores[k], unique_1[p_u].size(), target.size(),
+                                               Normaliser::SELF_SCORES ? p_batch.self_1[p_u * lanes + k] : 0.0,
+                                               Normaliser::SELF_SCORES ? p_batch.targets->self[j * lanes + k] : 0.0);
+        }
+        continue;
+      }
+
+      alignment::alignmentResult res = profiled
+          ? m_similarity->align(unique_1[p_u], target, local.profile, (*local.cols)[j], *local.scheme, mem)
+          : m_similarity->align(unique_1[p_u], target, *local.scheme, mem);
+      row[j] = Normaliser::normalise(res.score, unique_1[p_u].size(), target.size(),
+                                       Normaliser::SELF_SCORES ? p_batch.self_1[p_u] : 0.0,
+                                       Normaliser::SELF_SCORES ? p_batch.targets->self[j] : 0.0);
+      skipped += res.skipped;
+      capped += res.capped;
+
+      if (traced && !res.capped) {
+        lcas(res.trace, mem.trace(), p_batch.ids_1[p_u], p_batch.targets->ids[j], ids);
+        m_traceSink->write(p_u, j, row[j], res, mem.trace(), ids);
+      }
+
+#ifndef NDEBUG
+      std::cout << "Score: " << res.score << std::endl;
+      if (!m_options.scores) {
+        common::StringVec consensus_a, consensus_b;
+        mem.trace().materialise(res.trace, unique_1[p_u], unique_2[j], *m_scoringScheme, consensus_a, consensus_b);
+        std::cout << "Alignments: " << std::endl;
+        std::copy(consensus_a.begin(), consensus_a.end(), std::ostream_iterator<std::string>(std::cout, " "));
+        std::cout << std::endl;
+      }
+#endif /* NDEBUG */
+    }
+
+    for (boost::uint32_t c = 0; c < p_candidates.size(); ++c) {
+      if (!deferred[c]) {
+        continue;
+      }
+      boost::uint32_t j = p_candidates[c];
+
+      #pragma omp single
+      {
+        wavefront.reset(unique_1[p_u].size(), unique_2[j].size(), workers());
+      }
+
+      if (profiled) {
+        wavefront.align(local.profile, (*local.cols)[j], worker(), workers());
+      } else {
+        wavefront.align(unique_1[p_u], (*local.unique_2)[j], *local.scheme, worker(), workers());
+      }
+      #pragma omp barrier
+
+      #pragma omp single
+      {
+        row[j] = Normaliser::normalise(wavefront.score(), unique_1[p_u].size(), unique_2[j].size(),
+                                       Normaliser::SELF_SCORES ? p_batch.self_1[p_u] : 0.0,
+                                       Normaliser::SELF_SCORES ? p_batch.targets->self[j] : 0.0);
+        tiledPairs++;
+        capped += !m_options.scores;
+      }
+    }
+  }
+  release();
+
+  m_stats.skippedCells += skipped;
+  m_stats.cappedPairs += capped;
+  m_stats.approximatedPairs += approximated;
+  m_stats.wavefrontPairs += tiledPairs;
+
+  return filtered;
+}
+
+
+template <typename Normaliser>
+void Aligner::alignTrie(batch_t &p_batch, const PrefixTrie &p_trie, std::vector<double> &p_scores)
+{
+  common::Sequences &unique_1 = *p_batch.unique_1;
+  boost::uint32_t queries = unique_1.size();
+  boost::uint32_t targets = p_batch.unique_2->size();
+  bool sw = (m_options.alg == 1);
+
+  // the scores of every target are contiguous
+  p_scores.assign(static_cast<std::size_t>(targets) * queries, 0.0);
+
+  #pragma omp parallel shared(p_batch, p_trie, p_scores, unique_1, queries, targets, sw) default(none)
+  {
+    place();
+    alignment::MemoryPool &mem = pool();
+    replica_t &local = replica();
+    alignment::Profile profile;
+    std::vector<double> H_max(p_trie.maxDepth() + 1, 0.0);
+    double delta = local.scheme->getDelta();
+
+    #pragma omp for schedule(dynamic)
+    for (boost::uint32_t j = 0; j < targets; ++j) {
+      common::StringVec &target = (*local.unique_2)[j];
+      boost::uint32_t N_b = target.size();
+
+      // row x of the profile scores the x-th symbol of the queries against the target
+      profile.build(p_trie.alphabet(), target, *local.scheme);
+
+      // row d of H holds the row of the current prefix of length d, the
+      // rows of the nodes of the trie overwrite those of their siblings
+      mem.checkDimensions(p_trie.maxDepth() + 1, N_b + 1);
+      for (boost::uint32_t k = 0; k <= N_b; ++k) {
+        mem.H()[0][k] = sw ? 0.0 : -static_cast<boost::int32_t>(k) * delta;
+      }
+
+      for (boost::uint32_t n = 0; n < p_trie.size(); ++n) {
+        boost::uint32_t d = p_trie.depth(n);
+        double *cur = mem.H()[d];
+
+        if (n > 0) {
+          const double *prev = mem.H()[d - 1];
+          const double *s = profile.row(p_trie.symbol(n));
+
+          cur[0] = sw ? 0.0 : -static_cast<boost::int32_t>(d) * delta;
+          if (sw) {
+            double best = H_max[d - 1];
+            for (boost::uint32_t k = 1; k <= N_b; ++k) {
+              cur[k] = std::max(std::max(prev[k-1] + s[k-1], prev[k] - delta), std::max(cur[k-1] - delta, 0.0));
+              best = std::max(best, cur[k]);
+            }
+            H_max[d] = best;
+          } else {
+            for (boost::uint32_t k = 1; k <= N_b; ++k) {
+              cur[k] = std::max(std::max(prev[k-1] + s[k-1], prev[k] - delta), cur[k-1] - delta);
+            }
+          }
+        }
+
+        // the queries ending at this node are complete
+        const std::vector<boost::uint32_t> &ends = p_trie.ends(n);
+        for (std::vector<boost::uint32_t>::const_iterator q = ends.begin(); q != ends.end(); ++q) {
+          p_scores[static_cast<std::size_t>(j) * queries + *q] = Normaliser::normalise(
+              sw ? H_max[d] : cur[N_b], unique_1[*q].size(), N_b,
+              Normaliser::SELF_SCORES ? p_batch.self_1[*q] : 0.0,
+              Normaliser::SELF_SCORES ? p_batch.targets->self[j] : 0.0);
+        }
+      }
+    }
+  }
+  release();
+
+  m_stats.sharedRows = (p_trie.length() - (p_trie.size() - 1)) * targets;
+}
+
+
+template <typename Normaliser>
+void Aligner::extendPairs(batch_t &p_batch, const FrontierStore *p_previous, const std::vector<boost::uint32_t> &p_prev_1,
+                          const std::vector<boost::uint32_t> &p_prev_2, FrontierStore &p_next, std::vector<double> &p_scores)
+{
+  common::Sequences &unique_1 = *p_batch.unique_1;
+  boost::uint32_t targets = p_batch.unique_2->size();
+  boost::uint64_t pairs = static_cast<boost::uint64_t>(unique_1.size()) * targets;
+  alignment::Frontier frontier(m_options.alg == 1, m_options.gap_penalty);
+  boost::uint64_t reused = 0;
+
+  p_scores.assign(pairs, 0.0);
+
+  #pragma omp parallel shared(p_batch, p_previous, p_prev_1, p_prev_2, p_next, p_scores, unique_1, targets, pairs, frontier) reduction(+:reused) default(none)
+  {
+    place();
+    alignment::MemoryPool &mem = pool();
+    replica_t &local = replica();
+    alignment::Profile profile;
+    boost::uint32_t profiled = FrontierStore::NONE;
+    double empty[3];
+    alignment::Frontier::empty(empty);
+
+    #pragma omp for schedule(dynamic, 64)
+    for (boost::uint64_t k = 0; k < pairs; ++k) {
+      boost::uint32_t u = k / targets;
+      boost::uint32_t j = k % targets;
+      common::StringVec &target = (*local.unique_2)[j];
+
+      // the pairs of a query are consecutive, so the profile is rebuilt once per chunk at most
+      if (profiled != u) {
+        profile.build(unique_1[u], p_batch.targets->alphabet, *local.scheme);
+        profiled = u;
+      }
+
+      // a pair is extended, if both sequences grew from sequences of the previous run
+      const double *prev = empty;
+      boost::uint32_t prev_a = 0, prev_b = 0;
+      if (p_previous != NULL && p_prev_1[u] != FrontierStore::NONE && p_prev_2[j] != FrontierStore::NONE) {
+        prev = p_previous->frontier(p_prev_1[u], p_prev_2[j]);
+        prev_a = p_previous->length(0, p_prev_1[u]);
+        prev_b = p_previous->length(1, p_prev_2[j]);
+        reused += static_cast<boost::uint64_t>(prev_a) * prev_b;
+      }
+
+      double score = frontier.extend(unique_1[u], target, prev_a, prev_b, prev, p_next.frontier(u, j),
+                                     profile, (*local.cols)[j], mem);
+      p_scores[k] = Normaliser::normalise(score, unique_1[u].size(), target.size(),
+                                          Normaliser::SELF_SCORES ? p_batch.self_1[u] : 0.0,
+                                          Normaliser::SELF_SCORES ? p_batch.targets->self[j] : 0.0);
+    }
+  }
+  release();
+
+  m_stats.reusedCells = reused;
+}
+
+
+void Aligner::index(SequenceSet &p_targets)
+{
+  reservePools();
+
+  m_targets.reset(new targets_t);
+  m_targets->set = &p_targets;
+  common::Sequences &unique_2 = p_targets.unique();
+
+  // the self-alignment scores are computed once per unique sequence, the
+  // approximate scores only need those of the sampled pairs
+  if (m_options.norm == 3 && !m_minhash) {
+    selfScores(unique_2, m_targets->self);
+  }
+
+  if (m_minhash) {
+    sketch(unique_2, m_targets->sketches);
+  }
+
+  // the symbols used by the targets are the columns of the query profiles
+  std::unordered_map<const std::string*, boost::uint32_t> columns;
+  m_targets->cols.resize(unique_2.size());
+  for (boost::uint32_t u = 0; u < unique_2.size(); ++u) {
+    m_targets->cols[u].resize(unique_2[u].size());
+    for (boost::uint32_t k = 0; k < unique_2[u].size(); ++k) {
+      std::pair<std::unordered_map<const std::string*, boost::uint32_t>::iterator, bool> ins =
+          columns.insert(std::make_pair(&unique_2[u][k].get(), m_targets->alphabet.size()));
+      if (ins.second) {
+        m_targets->alphabet.push_back(unique_2[u][k]);
+      }
+      m_targets->cols[u][k] = ins.first->second;
+    }
+  }
+
+  // with NUMA placement, the workers of every node read their own copies of the
+  // scoring scheme and the targets, allocated and first touched by a worker on the node
+  boost::uint32_t replicas = m_options.numa ? std::min<std::size_t>(m_topology.nodes(), m_pools.size()) : 1;
+  m_targets->replicas.resize(replicas);
+
+  #pragma omp parallel shared(unique_2, replicas) default(none)
+  {
+    place();
+
+    if (worker() < replicas) {
+      replica_t *local = new replica_t;
+      if (m_options.numa) {
+        local->localScheme.reset(new TreePathSimilarityMeasure(*m_scoringScheme));
+        local->localUnique_2 = unique_2;
+        local->localCols = m_targets->cols;
+        local->scheme = local->localScheme.get();
+        local->unique_2 = &local->localUnique_2;
+        local->cols = &local->localCols;
+      } else {
+        local->scheme = m_scoringScheme.get();
+        local->unique_2 = &unique_2;
+        local->cols = &m_targets->cols;
+      }
+      m_targets->replicas[worker()].reset(local);
+    }
+  }
+  release();
+
+  // the tracebacks name the LCAs by their symbol IDs
+  if (!m_options.scores) {
+    encode(unique_2, m_targets->ids);
+  }
+
+  // optionally restrict the alignments to the candidate pairs sharing seeds
+  const HierarchyProjection &projection = m_hierarchy.projection();
+  if (m_options.seed_k > 0) {
+    m_targets->seeds.reset(new SeedIndex(projection, unique_2, m_options.seed_k, m_options.seed_level, m_options.seed_min));
+  }
+
+  // optionally filter the candidate pairs by a cheap alignment of the sequences projected
+  // onto a coarse level of the hierarchy with their runs of identical ancestors collapsed
+  if (m_options.coarse_level > 0) {
+    m_targets->coarse.resize(unique_2.size());
+    for (boost::uint32_t u = 0; u < unique_2.size(); ++u) {
+      projection.coarsen(unique_2[u], m_options.coarse_level, m_targets->coarse[u]);
+    }
+
+    m_targets->coarseScheme.reset(new LevelTreePathSimilarityMeasure(m_options.gap_penalty, projection, m_options.coarse_level));
+    m_targets->coarseSimilarity.reset(algorithm(true));
+  }
+}
+
+
+void Aligner::align(SequenceSet &p_queries, const std::vector<ScoreSink*> &p_sinks)
+{
+  reservePools();
+
+  m_stats = alignStats();
+
+  SequenceSet &targets = *m_targets->set;
+  common::Sequences &unique_1 = p_queries.unique();
+  common::Sequences &unique_2 = targets.unique();
+  m_stats.pairs = static_cast<boost::uint64_t>(unique_1.size()) * unique_2.size();
+
+  batch_t batch;
+  batch.unique_1 = &unique_1;
+  batch.unique_2 = &unique_2;
+  batch.targets = m_targets.get();
+
+  // the workers allocate and pre-fault the matrices of the largest pair up front,
+  // unless the run-length encoded kernel scores the pairs in linear space
+  boost::uint32_t lanes = this->lanes();
+  if (!(m_options.rle && m_options.scores) && !m_minhash) {
+    boost::uint32_t rows = 0, cols = 0;
+    if (m_sweep) {
+      // the sweep keeps two rows and the maxima of all lanes
+      for (boost::uint32_t u = 0; u < unique_2.size(); ++u) {
+        cols = std::max<boost::uint32_t>(cols, unique_2[u].size() + 1);
+      }
+      cols *= lanes;
+      rows = 3;
+    } else {
+      // the pairs of the wavefront never use the pool; the longest target of every
+      // query below the threshold is found in the sorted lengths of set 2
+      std::vector<boost::uint32_t> lengths;
+      for (boost::uint32_t u = 0; u < unique_2.size(); ++u) {
+        lengths.push_back(unique_2[u].size());
+      }
+      std::sort(lengths.begin(), lengths.end());
+      lengths.erase(std::unique(lengths.begin(), lengths.end()), lengths.end());
+
+      boost::uint64_t cells = 0;
+      for (boost::uint32_t u = 0; u < unique_1.size(); ++u) {
+        boost::uint32_t a = unique_1[u].size();
+        std::vector<boost::uint32_t>::iterator b = lengths.begin();
+        for (boost::uint32_t n = lengths.size(); n > 0;) {
+          boost::uint32_t half = n / 2;
+          if (!tiles(m_pools[0], a, *(b + half))) {
+            b += half + 1;
+            n -= half + 1;
+          } else {
+            n = half;
+          }
+        }
+        if (b != lengths.begin() && static_cast<boost::uint64_t>(a + 1) * (*(b - 1) + 1) > cells) {
+          rows = a + 1;
+          cols = *(b - 1) + 1;
+          cells = static_cast<boost::uint64_t>(rows) * cols;
+        }
+      }
+    }
+
+    #pragma omp parallel shared(rows, cols) default(none)
+    {
+      place();
+      pool().reserve(rows, cols);
+    }
+    release();
+  }
+
+  if (m_options.norm == 3 && !m_minhash) {
+    selfScores(unique_1, batch.self_1);
+  }
+
+  // the approximate scores are mapped onto the scale of the normalised
+  // scores of the local alignments of a sample of the pairs
+  if (m_minhash) {
+    sketch(unique_1, batch.sketches_1);
+    switch (m_options.norm) {
+      case 1:
+        calibrate<SquaredMinNormaliser>(batch);
+        break;
+      case 2:
+        calibrate<MaxLengthNormaliser>(batch);
+        break;
+      case 3:
+        calibrate<SelfScoreNormaliser>(batch);
+        break;
+      default:
+        calibrate<RawNormaliser>(batch);
+        break;
+    }
+  }
+
+  if (m_options.coarse_level > 0) {
+    const HierarchyProjection &projection = m_hierarchy.projection();
+    batch.coarse_1.resize(unique_1.size());
+    for (boost::uint32_t u = 0; u < unique_1.size(); ++u) {
+      projection.coarsen(unique_1[u], m_options.coarse_level, batch.coarse_1[u]);
+    }
+  }
+
+  if (m_traceSink && !m_options.scores) {
+    encode(unique_1, batch.ids_1);
+    m_traceSink->begin(p_queries, targets);
+  }
+
+  // the rows of the common prefixes of the queries are computed once per target
+  if (m_options.trie) {
+    PrefixTrie trie(unique_1);
+    std::vector<double> scores;
+    switch (m_options.norm) {
+      case 1:
+        alignTrie<SquaredMinNormaliser>(batch, trie, scores);
+        break;
+      case 2:
+        alignTrie<MaxLengthNormaliser>(batch, trie, scores);
+        break;
+      case 3:
+        alignTrie<SelfScoreNormaliser>(batch, trie, scores);
+        break;
+      default:
+        alignTrie<RawNormaliser>(batch, trie, scores);
+        break;
+    }
+    m_stats.candidates = m_stats.pairs;
+
+    std::vector<double> row(unique_2.size());
+    for (boost::uint32_t i = 0; i < p_queries.size(); ++i) {
+      for (boost::uint32_t j = 0; j < unique_2.size(); ++j) {
+        row[j] = scores[static_cast<std::size_t>(j) * unique_1.size() + p_queries.id(i)];
+      }
+      p_sinks[0]->write(i, targets, row);
+    }
+
+    return;
+  }
+
+  // the scores of a unique query against all unique targets are memoised until
+  // the last position of the query set referring to it has been delivered,
+  // unless they exceed the row cache, in which case they are computed again.
+  // The rows of the alignments written by the trace sink are always kept.
+  std::vector<std::vector<std::vector<double> > > rows(unique_1.size());
+  std::vector<boost::uint32_t> pending(unique_1.size());
+  for (boost::uint32_t u = 0; u < unique_1.size(); ++u) {
+    pending[u] = p_queries.multiplicity(u);
+  }
+  std::vector<bool> computed(unique_1.size(), false);
+  boost::uint64_t rowBytes = static_cast<boost::uint64_t>(lanes) * unique_2.size() * sizeof(double);
+  boost::uint64_t cached = 0;
+  bool evict = (m_options.row_cache > 0) && !(m_traceSink && !m_options.scores);
+
+  std::vector<boost::uint32_t> candidates;
+
+  for (boost::uint32_t i = 0; i < p_queries.size(); ++i) {
+    boost::uint32_t u = p_queries.id(i);
+    std::vector<std::vector<double> > &row = rows[u];
+    bool fresh = row.empty();
+
+    if (fresh) {
+      m_stats.recomputedRows += computed[u];
+      computed[u] = true;
+
+      // pairs filtered by the seed stage are not similar
+      row.assign(lanes, std::vector<double>(unique_2.size(), 0.0));
+
+      if (m_targets->seeds) {
+        m_targets->seeds->candidates(unique_1[u], candidates);
+      } else {
+        candidates.resize(unique_2.size());
+        for (boost::uint32_t j = 0; j < unique_2.size(); ++j) {
+          candidates[j] = j;
+        }
+      }
+      m_stats.candidates += candidates.size();
+
+      switch (m_options.norm) {
+        case 1:
+          m_stats.coarseFiltered += alignRow<SquaredMinNormaliser>(batch, u, candidates, row);
+          break;
+        case 2:
+          m_stats.coarseFiltered += alignRow<MaxLengthNormaliser>(batch, u, candidates, row);
+          break;
+        case 3:
+          m_stats.coarseFiltered += alignRow<SelfScoreNormaliser>(batch, u, candidates, row);
+          break;
+        default:
+          m_stats.coarseFiltered += alignRow<RawNormaliser>(batch, u, candidates, row);
+          break;
+      }
+    }
+
+    for (boost::uint32_t k = 0; k < lanes; ++k) {
+      if (p_sinks[k] != NULL) {
+        p_sinks[k]->write(i, targets, row[k]);
+      }
+    }
+
+    if (--pending[u] == 0) {
+      cached -= fresh ? 0 : rowBytes;
+      std::vector<std::vector<double> >().swap(row);
+    } else if (fresh && evict && cached + rowBytes > m_options.row_cache) {
+      std::vector<std::vector<double> >().swap(row);
+    } else if (fresh) {
+      cached += rowBytes;
+    }
+  }
+
+  if (m_traceSink && !m_options.scores) {
+    m_traceSink->end();
+  }
+}
+
+
+void Aligner::extend(SequenceSet &p_queries, const FrontierStore *p_previous, FrontierStore &p_next, ScoreSink &p_sink)
+{
+  reservePools();
+
+  m_stats = alignStats();
+
+  SequenceSet &targets = *m_targets->set;
+  common::Sequences &unique_1 = p_queries.unique();
+  common::Sequences &unique_2 = targets.unique();
+  m_stats.pairs = static_cast<boost::uint64_t>(unique_1.size()) * unique_2.size();
+  m_stats.candidates = m_stats.pairs;
+
+  batch_t batch;
+  batch.unique_1 = &unique_1;
+  batch.unique_2 = &unique_2;
+  batch.targets = m_targets.get();
+
+  if (m_options.norm == 3) {
+    selfScores(unique_1, batch.self_1);
+  }
+
+  // the previous sequences the unique sequences grew from
+  std::vector<boost::uint32_t> prev_1, prev_2;
+  if (p_previous != NULL) {
+    p_previous->match(p_queries, 0, prev_1);
+    p_previous->match(targets, 1, prev_2);
+  }
+
+  std::vector<double> scores;
+  switch (m_options.norm) {
+    case 1:
+      extendPairs<SquaredMinNormaliser>(batch, p_previous, prev_1, prev_2, p_next, scores);
+      break;
+    case 2:
+      extendPairs<MaxLengthNormaliser>(batch, p_previous, prev_1, prev_2, p_next, scores);
+      break;
+    case 3:
+      extendPairs<SelfScoreNormaliser>(batch, p_previous, prev_1, prev_2, p_next, scores);
+      break;
+    default:
+      extendPairs<RawNormaliser>(batch, p_previous, prev_1, prev_2, p_next, scores);
+      break;
+  }
+
+  std::vector<double> row;
+  for (boost::uint32_t i = 0; i < p_queries.size(); ++i) {
+    std::vector<double>::const_iterator first = scores.begin() + static_cast<std::size_t>(p_queries.id(i)) * unique_2.size();
+    row.assign(first, first + unique_2.size());
+    p_sink.write(i, targets, row);
+  }
+}
+
+
+alignment::alignmentResult Aligner::align(common::StringVec &p_a, common::StringVec &p_b)
+{
+  reservePools();
+  m_pools[0].trace().reset();
+
+  return m_similarity->align(p_a, p_b, *m_scoringScheme, m_pools[0]);
+}
+
+
+void Aligner::materialise(const alignment::alignmentResult &p_res, common::StringVec &p_a, common::StringVec &p_b,
+                          common::StringVec &p_consensus_a, common::StringVec &p_consensus_b)
+{
+  m_pools[0].trace().materialise(p_res.trace, p_a, p_b, *m_scoringScheme, p_consensus_a, p_consensus_b);
+}
+
+
+}
@@ -0,0 +1,258 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file AlignmentWriter.cc
+ * Implementation of the streamed output of the alignments of a batch.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <cstring>
+
+#ifdef _OPENMP
+# include <omp.h>
+#endif /* _OPENMP */
+
+#include "AlignmentWriter.hh"
+#include "TreePathSimilarityMeasure.hh"
+
+
+namespace ha
+{
+
+
+template <typename T>
+static void put(std::vector<char> &p_buffer, T p_value)
+{
+  std::size_t size = p_buffer.size();
+  p_buffer.resize(size + sizeof(T));
+  std::memcpy(&p_buffer[size], &p_value, sizeof(T));
+}
+
+
+template <typename T>
+static T get(const char *&p_pos)
+{
+  T value;
+  std::memcpy(&value, p_pos, sizeof(T));
+  p_pos += sizeof(T);
+  return value;
+}
+
+
+AlignmentWriter::AlignmentWriter(std::ostream &p_out, bool p_binary)
+    : m_out(p_out), m_binary(p_binary), m_busy(false), m_done(false),
+      m_thread(&AlignmentWriter::run, this)
+{}
+
+
+AlignmentWriter::~AlignmentWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_done = true;
+  }
+  m_ready.notify_one();
+  m_thread.join();
+}
+
+
+void AlignmentWriter::begin(SequenceSet &p_queries, SequenceSet &p_targets)
+{
+  m_positions_1.assign(p_queries.uniqueSize(), std::vector<boost::uint32_t>());
+  for (boost::uint32_t i = 0; i < p_queries.size(); ++i) {
+    m_positions_1[p_queries.id(i)].push_back(i);
+  }
+  m_positions_2.assign(p_targets.uniqueSize(), std::vector<boost::uint32_t>());
+  for (boost::uint32_t j = 0; j < p_targets.size(); ++j) {
+    m_positions_2[p_targets.id(j)].push_back(j);
+  }
+
+#ifdef _OPENMP
+  m_buffers.resize(omp_get_max_threads());
+#else
+  m_buffers.resize(1);
+#endif /* _OPENMP */
+}
+
+
+void AlignmentWriter::write(boost::uint32_t p_u, boost::uint32_t p_v, double p_score,
+                            const alignment::alignmentResult &p_res, const alignment::TraceArena &p_arena,
+                            const std::vector<boost::uint32_t> &p_lcas)
+{
+#ifdef _OPENMP
+  std::vector<char> &buffer = m_buffers[omp_get_thread_num()];
+#else
+  std::vector<char> &buffer = m_buffers[0];
+#endif /* _OPENMP */
+
+  // the record of a pair is laid out as in the binary output
+  put<boost::uint32_t>(buffer, p_u);
+  put<boost::uint32_t>(buffer, p_v);
+  put<double>(buffer, p_score);
+  put<double>(buffer, p_res.score);
+  put<boost::uint32_t>(buffer, p_res.trace.begin_i);
+  put<boost::uint32_t>(buffer, p_res.trace.begin_j);
+  put<boost::uint32_t>(buffer, p_res.trace.end_i);
+  put<boost::uint32_t>(buffer, p_res.trace.end_j);
+  put<boost::uint32_t>(buffer, p_res.trace.length);
+  for (boost::uint32_t k = 0; k < p_res.trace.length; ++k) {
+    put<boost::uint32_t>(buffer, (p_arena.count(p_res.trace, k) << 2) | p_arena.op(p_res.trace, k));
+  }
+  put<boost::uint32_t>(buffer, p_lcas.size());
+  for (boost::uint32_t k = 0; k < p_lcas.size(); ++k) {
+    put<boost::uint32_t>(buffer, p_lcas[k]);
+  }
+
+  if (buffer.size() >= BUFFER_SIZE) {
+    submit(buffer);
+  }
+}
+
+
+void AlignmentWriter::end()
+{
+  for (std::size_t t = 0; t < m_buffers.size(); ++t) {
+    if (!m_buffers[t].empty()) {
+      submit(m_buffers[t]);
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_idle.wait(lock, [this] { return m_queue.empty() && !m_busy; });
+  m_out.flush();
+}
+
+
+void AlignmentWriter::submit(std::vector<char> &p_buffer)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_space.wait(lock, [this] { return m_queue.size() < QUEUE_SIZE; });
+
+  // hand the buffer over and continue with a written one
+  m_queue.push_back(std::vector<char>());
+  m_queue.back().swap(p_buffer);
+  if (!m_free.empty()) {
+    p_buffer.swap(m_free.back());
+    m_free.pop_back();
+  }
+  p_buffer.clear();
+
+  m_ready.notify_one();
+}
+
+
+void AlignmentWriter::run()
+{
+  std::vector<char> buffer;
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_ready.wait(lock, [this] { return !m_queue.empty() || m_done; });
+      if (m_queue.empty()) {
+        return;
+      }
+      buffer.swap(m_queue.front());
+      m_queue.pop_front();
+      m_busy = true;
+    }
+    m_space.notify_one();
+
+    format(buffer);
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_free.push_back(std::vector<char>());
+      m_free.back().swap(buffer);
+      m_busy = false;
+    }
+    m_idle.notify_all();
+  }
+}
+
+
+void AlignmentWriter::format(const std::vector<char> &p_buffer)
+{
+  static const char OPS[] = { 'M', 'I', 'D' };
+  const char *pos = p_buffer.empty() ? NULL : &p_buffer[0];
+  const char *last = pos + p_buffer.size();
+
+  while (pos < last) {
+    const char *record = pos;
+    boost::uint32_t u = get<boost::uint32_t>(pos);
+    boost::uint32_t v = get<boost::uint32_t>(pos);
+    double score = get<double>(pos);
+    double raw = get<double>(pos);
+    boost::uint32_t begin_i = get<boost::uint32_t>(pos);
+    boost::uint32_t begin_j = get<boost::uint32_t>(pos);
+    boost::uint32_t end_i = get<boost::uint32_t>(pos);
+    boost::uint32_t end_j = get<boost::uint32_t>(pos);
+    const char *ops = pos;
+    boost::uint32_t nops = get<boost::uint32_t>(pos);
+    pos += nops * sizeof(boost::uint32_t);
+    boost::uint32_t nlcas = get<boost::uint32_t>(pos);
+    const char *lcas = pos;
+    pos += nlcas * sizeof(boost::uint32_t);
+
+    // every position of the query against every position of the target
+    const std::vector<boost::uint32_t> &positions_1 = m_positions_1[u];
+    const std::vector<boost::uint32_t> &positions_2 = m_positions_2[v];
+
+    for (std::size_t a = 0; a < positions_1.size(); ++a) {
+      for (std::size_t b = 0; b < positions_2.size(); ++b) {
+        if (m_binary) {
+          m_out.write(reinterpret_cast<const char*>(&positions_1[a]), sizeof(boost::uint32_t));
+          m_out.write(reinterpret_cast<const char*>(&positions_2[b]), sizeof(boost::uint32_t));
+          m_out.write(record + 2 * sizeof(boost::uint32_t), pos - record - 2 * sizeof(boost::uint32_t));
+          continue;
+        }
+
+        m_out << positions_1[a] << "\t" << positions_2[b] << "\t" << score << "\t" << raw << "\t"
+              << begin_i << "\t" << begin_j << "\t" << end_i << "\t" << end_j << "\t";
+
+        const char *op = ops + sizeof(boost::uint32_t);
+        for (boost::uint32_t k = 0; k < nops; ++k) {
+          boost::uint32_t entry = get<boost::uint32_t>(op);
+          m_out << (entry >> 2) << OPS[entry & 3];
+        }
+        m_out << "\t";
+
+        const char *lca = lcas;
+        for (boost::uint32_t k = 0; k < nlcas; ++k) {
+          boost::uint32_t id = get<boost::uint32_t>(lca);
+          m_out << ((k > 0) ? "," : "");
+          if (id == TreePathSimilarityMeasure::UNKNOWN) {
+            m_out << "-1";
+          } else {
+            m_out << id;
+          }
+        }
+        m_out << "\n";
+      }
+    }
+  }
+}
+
+
+}
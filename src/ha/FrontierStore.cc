@@ -0,0 +1,249 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file FrontierStore.cc
+ * Implementation of the memory-mapped store of the frontiers of all pairs of two sets.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+
+#include "FrontierStore.hh"
+
+namespace io = boost::iostreams;
+
+
+namespace ha
+{
+
+
+/* the first bytes of a file of frontiers */
+static const char MAGIC[8] = { 'H', 'A', 'F', 'R', 'O', 'N', 'T', '1' };
+
+static const boost::uint64_t FNV_OFFSET = UINT64_C(14695981039346656037);
+static const boost::uint64_t FNV_PRIME = UINT64_C(1099511628211);
+
+const boost::uint32_t FrontierStore::NONE;
+
+
+/* the offset of the hashes behind the counts, the IDs and the lengths */
+static std::size_t hashes(const boost::uint32_t *p_counts)
+{
+  std::size_t bytes = sizeof(MAGIC) + sizeof(boost::uint32_t) *
+      (4 + static_cast<std::size_t>(p_counts[0]) + p_counts[1] + p_counts[2] + p_counts[3]);
+  return (bytes + 7) & ~static_cast<std::size_t>(7);
+}
+
+/* the offset of the frontiers behind the hashes */
+static std::size_t frontiers(const boost::uint32_t *p_counts)
+{
+  return hashes(p_counts) + sizeof(boost::uint64_t) * (static_cast<std::size_t>(p_counts[2]) + p_counts[3]);
+}
+
+
+boost::uint64_t FrontierStore::hash(const common::StringVec &p_seq, boost::uint32_t p_len)
+{
+  boost::uint64_t h = FNV_OFFSET;
+  for (boost::uint32_t k = 0; k < p_len; ++k) {
+    const std::string &symbol = p_seq[k].get();
+    for (std::string::const_iterator it = symbol.begin(); it != symbol.end(); ++it) {
+      h ^= static_cast<unsigned char>(*it);
+      h *= FNV_PRIME;
+    }
+    h ^= static_cast<unsigned char>(',');
+    h *= FNV_PRIME;
+  }
+  return h;
+}
+
+
+bool FrontierStore::open(const std::string &p_filename)
+{
+  close();
+
+  try {
+    m_file.open(p_filename, io::mapped_file::readonly);
+  } catch (std::exception &e) {
+    std::cerr << "Could not map file: " << p_filename << " (" << e.what() << ")" << std::endl;
+    return false;
+  }
+
+  if (!layout(p_filename)) {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+
+bool FrontierStore::create(const std::string &p_filename, SequenceSet &p_set_1, SequenceSet &p_set_2)
+{
+  close();
+
+  boost::uint32_t counts[4] = { static_cast<boost::uint32_t>(p_set_1.size()), static_cast<boost::uint32_t>(p_set_2.size()),
+                                static_cast<boost::uint32_t>(p_set_1.uniqueSize()), static_cast<boost::uint32_t>(p_set_2.uniqueSize()) };
+  SequenceSet *sets[2] = { &p_set_1, &p_set_2 };
+
+  // every pair keeps a cell per symbol of both sequences and three more
+  boost::uint64_t length[2] = { 0, 0 };
+  for (boost::uint32_t s = 0; s < 2; ++s) {
+    for (boost::uint32_t u = 0; u < sets[s]->uniqueSize(); ++u) {
+      length[s] += sets[s]->unique()[u].size();
+    }
+  }
+  boost::uint64_t cells = length[0] * counts[3] + length[1] * counts[2] + UINT64_C(3) * counts[2] * counts[3];
+
+  // the file is created by a stream first, so that it gets the permissions of the umask
+  std::ofstream(p_filename.c_str(), std::ios::out | std::ios::binary);
+
+  io::mapped_file_params params(p_filename);
+  params.flags = io::mapped_file::readwrite;
+  params.new_file_size = frontiers(counts) + cells * sizeof(double);
+  try {
+    m_file.open(params);
+  } catch (std::exception &e) {
+    std::cerr << "Could not create file: " << p_filename << " (" << e.what() << ")" << std::endl;
+    return false;
+  }
+
+  char *base = m_file.data();
+  std::memcpy(base, MAGIC, sizeof(MAGIC));
+  boost::uint32_t *words = reinterpret_cast<boost::uint32_t*>(base + sizeof(MAGIC));
+  std::copy(counts, counts + 4, words);
+  words += 4;
+  for (boost::uint32_t s = 0; s < 2; ++s) {
+    for (boost::uint32_t i = 0; i < sets[s]->size(); ++i) {
+      *words++ = sets[s]->id(i);
+    }
+  }
+  for (boost::uint32_t s = 0; s < 2; ++s) {
+    for (boost::uint32_t u = 0; u < sets[s]->uniqueSize(); ++u) {
+      *words++ = sets[s]->unique()[u].size();
+    }
+  }
+
+  boost::uint64_t *digests = reinterpret_cast<boost::uint64_t*>(base + hashes(counts));
+  for (boost::uint32_t s = 0; s < 2; ++s) {
+    for (boost::uint32_t u = 0; u < sets[s]->uniqueSize(); ++u) {
+      *digests++ = hash(sets[s]->unique()[u], sets[s]->unique()[u].size());
+    }
+  }
+
+  if (!layout(p_filename)) {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+
+void FrontierStore::close()
+{
+  if (m_file.is_open()) {
+    m_file.close();
+  }
+  m_data = NULL;
+}
+
+
+bool FrontierStore::layout(const std::string &p_filename)
+{
+  const char *base = m_file.const_data();
+  std::size_t size = m_file.size();
+
+  if (size < sizeof(MAGIC) + 4 * sizeof(boost::uint32_t) || std::memcmp(base, MAGIC, sizeof(MAGIC)) != 0) {
+    std::cerr << "The file " << p_filename << " does not hold frontiers!" << std::endl;
+    return false;
+  }
+
+  const boost::uint32_t *counts = reinterpret_cast<const boost::uint32_t*>(base + sizeof(MAGIC));
+  if (size < frontiers(counts)) {
+    std::cerr << "The frontiers " << p_filename << " are truncated!" << std::endl;
+    return false;
+  }
+
+  m_positions[0] = counts[0];
+  m_positions[1] = counts[1];
+  m_unique[0] = counts[2];
+  m_unique[1] = counts[3];
+  m_ids[0] = counts + 4;
+  m_ids[1] = m_ids[0] + m_positions[0];
+  m_lengths[0] = m_ids[1] + m_positions[1];
+  m_lengths[1] = m_lengths[0] + m_unique[0];
+  m_hashes[0] = reinterpret_cast<const boost::uint64_t*>(base + hashes(counts));
+  m_hashes[1] = m_hashes[0] + m_unique[0];
+  m_data = reinterpret_cast<double*>(const_cast<char*>(base + frontiers(counts)));
+
+  // the frontiers of the targets of a query follow each other
+  boost::uint64_t row = 0;
+  m_cum.resize(m_unique[1]);
+  for (boost::uint32_t v = 0; v < m_unique[1]; ++v) {
+    m_cum[v] = row;
+    row += m_lengths[1][v] + 1;
+  }
+
+  boost::uint64_t cells = 0;
+  m_base.resize(m_unique[0]);
+  for (boost::uint32_t u = 0; u < m_unique[0]; ++u) {
+    m_base[u] = cells;
+    cells += row + static_cast<boost::uint64_t>(m_unique[1]) * (m_lengths[0][u] + 2);
+  }
+
+  if (size != frontiers(counts) + cells * sizeof(double)) {
+    std::cerr << "The frontiers " << p_filename << " are truncated!" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+void FrontierStore::match(SequenceSet &p_set, boost::uint32_t p_side, std::vector<boost::uint32_t> &p_prev) const
+{
+  p_prev.assign(p_set.uniqueSize(), NONE);
+
+  const boost::uint32_t *lengths = m_lengths[p_side];
+  std::size_t positions = std::min<std::size_t>(p_set.size(), m_positions[p_side]);
+  for (std::size_t i = 0; i < positions; ++i) {
+    boost::uint32_t o = m_ids[p_side][i];
+    boost::uint32_t u = p_set.id(i);
+    const common::StringVec &seq = p_set.unique()[u];
+
+    if (lengths[o] > seq.size() || (p_prev[u] != NONE && lengths[p_prev[u]] >= lengths[o])) {
+      continue;
+    }
+    if (hash(seq, lengths[o]) == m_hashes[p_side][o]) {
+      p_prev[u] = o;
+    }
+  }
+}
+
+
+}
@@ -0,0 +1,212 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Hierarchy.cc
+ * Implementation of the loading of the hierarchical classification scheme.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#ifndef NDEBUG
+# include <iterator>
+#endif /* NDEBUG */
+
+#include <algorithm>
+#include <iostream>
+
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+
+#include "Hierarchy.hh"
+#include "Streams.hh"
+
+
+#ifndef NDEBUG
+namespace std
+{
+
+std::ostream& operator<<(std::ostream &os, const common::StringIntMap::value_type &v) {
+  return os << v.first << ": " << v.second;
+}
+
+std::ostream& operator<<(std::ostream &os, const common::StrStrMap::value_type &v) {
+  return os << std::get<0>(v.first) << ", " << std::get<1>(v.first) << ": " << v.second;
+}
+
+}
+#endif /* NDEBUG */
+
+
+namespace ha
+{
+
+
+bool Hierarchy::load(const std::string &p_levels, const std::string &p_positions, const std::string &p_lca)
+{
+  if (!loadLevels(p_levels) || !loadPositions(p_positions) || !loadLcas(p_lca)) {
+    return false;
+  }
+
+  m_projection.reset(new HierarchyProjection(m_levels, m_positions));
+
+  return true;
+}
+
+
+bool Hierarchy::loadLevels(const std::string &p_filename)
+{
+  // parse the euler levels
+  InputFile eulerLevelsFile;
+  eulerLevelsFile.open(p_filename);
+  if (!eulerLevelsFile.is_open()) {
+    std::cerr << "Could not open file: " << p_filename << std::endl;
+    return false;
+  }
+
+#ifndef NDEBUG
+  std::cout << "Reading the Euler Levels..." << std::endl;
+#endif /* NDEBUG */
+
+  std::string line;
+  while (!eulerLevelsFile.eof()) {
+    std::getline(eulerLevelsFile, line);
+#ifndef NDEBUG
+    std::cout << "Read line: " << line << std::endl;
+#endif /* NDEBUG */
+
+    if (line != "") {
+      boost::algorithm::trim(line);
+      m_levels.push_back(boost::lexical_cast<boost::uint32_t>(line));
+    }
+  }
+  eulerLevelsFile.close();
+
+#ifndef NDEBUG
+  std::cout << std::endl << "Euler Levels:  ";
+  std::copy(m_levels.begin(), m_levels.end(), std::ostream_iterator<double>(std::cout, "\t"));
+  std::cout << std::endl;
+#endif /* NDEBUG */
+
+  return true;
+}
+
+
+bool Hierarchy::loadPositions(const std::string &p_filename)
+{
+  // parse the euler positions
+  InputFile eulerPositionsFile;
+  eulerPositionsFile.open(p_filename);
+  if (!eulerPositionsFile.is_open()) {
+    std::cerr << "Could not open file: " << p_filename << std::endl;
+    return false;
+  }
+
+#ifndef NDEBUG
+  std::cout << "Reading the Euler Positions..." << std::endl;
+#endif /* NDEBUG */
+
+  std::string line;
+  while (!eulerPositionsFile.eof()) {
+    std::getline(eulerPositionsFile, line);
+#ifndef NDEBUG
+    std::cout << "Read line: " << line << std::endl;
+#endif /* NDEBUG */
+
+    if (line != "") {
+      common::StringVec tokens;
+      boost::split(tokens, line, boost::is_any_of(","), boost::token_compress_on);
+      if (tokens.size() != 2) {
+        eulerPositionsFile.close();
+        std::cerr << "Each line of the euler positions file can only contain two tokens: <key>,<value>!" << std::endl;
+        return false;
+      } else {
+        if (m_positions.find(tokens[0]) != m_positions.end()) {
+          eulerPositionsFile.close();
+          std::cerr << "The Euler Positions cannot contain duplicates: " << tokens[0] << std::endl;
+          return false;
+        } else {
+          m_positions[tokens[0]] = boost::lexical_cast<boost::uint32_t>(tokens[1]);
+        }
+      }
+    }
+  }
+  eulerPositionsFile.close();
+
+#ifndef NDEBUG
+  std::cout << std::endl << "Euler Positions:  ";
+  std::copy(m_positions.begin(), m_positions.end(), std::ostream_iterator<common::StringIntMap::value_type>(std::cout, "\t"));
+  std::cout << std::endl;
+#endif /* NDEBUG */
+
+  return true;
+}
+
+
+bool Hierarchy::loadLcas(const std::string &p_filename)
+{
+  InputFile lcaFile;
+  lcaFile.open(p_filename);
+  if (!lcaFile.is_open()) {
+    std::cerr << "Could not open file: " << p_filename << std::endl;
+    return false;
+  }
+
+#ifndef NDEBUG
+  std::cout << "Reading the lca..." << std::endl;
+#endif /* NDEBUG */
+
+  std::string line;
+  while (!lcaFile.eof()) {
+    std::getline(lcaFile, line);
+#ifndef NDEBUG
+    std::cout << "Read line: " << line << std::endl;
+#endif /* NDEBUG */
+
+    if (line != "") {
+      common::StringVec tokens;
+      boost::split(tokens, line, boost::is_any_of(","), boost::token_compress_on);
+      if (tokens.size() != 3) {
+        std::cerr << "The LCA requires three tokens, got: " << tokens.size() << std::endl;
+        lcaFile.close();
+        return false;
+      }
+      m_lcas[std::make_tuple(tokens[0], tokens[1])] = common::Symbol(tokens[2]);
+    }
+  }
+  lcaFile.close();
+
+#ifndef NDEBUG
+  std::cout << std::endl << "LCAs:  ";
+  std::copy(m_lcas.begin(), m_lcas.end(), std::ostream_iterator<common::StrStrMap::value_type>(std::cout, "\t"));
+  std::cout << std::endl;
+#endif /* NDEBUG */
+
+  return true;
+}
+
+
+}
@@ -0,0 +1,105 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file SequenceSet.cc
+ * Implementation of the loading of a hash-consed set of sequences.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#ifndef NDEBUG
+# include <algorithm>
+# include <iterator>
+#endif /* NDEBUG */
+
+#include <iostream>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+
+#include "SequenceSet.hh"
+#include "Streams.hh"
+
+
+#ifndef NDEBUG
+namespace std
+{
+
+std::ostream& operator<<(std::ostream &os, const common::StringVec &v) {
+  std::copy(v.begin(), v.end(), std::ostream_iterator<common::Symbol>(os, "\t"));
+  return os;
+}
+
+}
+#endif /* NDEBUG */
+
+
+namespace ha
+{
+
+
+void SequenceSet::parse(const std::string &p_line, common::StringVec &p_seq)
+{
+  boost::split(p_seq, p_line, boost::is_any_of(","), boost::token_compress_on);
+}
+
+
+bool SequenceSet::load(const std::string &p_filename)
+{
+  InputFile setFile;
+  setFile.open(p_filename);
+  if (!setFile.is_open()) {
+    std::cerr << "Could not open file: " << p_filename << std::endl;
+    return false;
+  }
+
+#ifndef NDEBUG
+  std::cout << "Reading the set " << p_filename << "..." << std::endl;
+#endif /* NDEBUG */
+
+  std::string line;
+  while (!setFile.eof()) {
+    std::getline(setFile, line);
+#ifndef NDEBUG
+    std::cout << "Read line: " << line << std::endl;
+#endif /* NDEBUG */
+
+    if (line != "") {
+      common::StringVec cats;
+      parse(line, cats);
+      add(cats);
+    }
+  }
+  setFile.close();
+
+#ifndef NDEBUG
+  std::cout << std::endl << "Sequences:  ";
+  std::copy(m_unique.begin(), m_unique.end(), std::ostream_iterator<common::StringVec>(std::cout, "\n"));
+  std::cout << std::endl;
+#endif /* NDEBUG */
+
+  return true;
+}
+
+
+}
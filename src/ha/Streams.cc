@@ -0,0 +1,311 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Streams.cc
+ * Implementation of the file streams reading and writing compressed files.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#ifdef HAVE_BOOST_IOSTREAMS_ZSTD
+# include <boost/iostreams/filter/zstd.hpp>
+#endif /* HAVE_BOOST_IOSTREAMS_ZSTD */
+
+#include "Streams.hh"
+
+namespace io = boost::iostreams;
+
+
+namespace ha
+{
+
+
+bool InputFile::open(const std::string &p_filename)
+{
+  reset();
+
+  std::ifstream probe(p_filename.c_str(), std::ios::in | std::ios::binary);
+  if (!probe.is_open()) {
+    return false;
+  }
+
+  // the codec is recognised by the magic bytes, not by the extension
+  unsigned char magic[4] = { 0, 0, 0, 0 };
+  probe.read(reinterpret_cast<char*>(magic), sizeof(magic));
+  probe.close();
+
+  if (magic[0] == 0x1f && magic[1] == 0x8b) {
+    push(io::gzip_decompressor());
+  } else if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+#ifdef HAVE_BOOST_IOSTREAMS_ZSTD
+    push(io::zstd_decompressor());
+#else
+    std::cerr << "The file " << p_filename << " is compressed with zstd, which this build does not support!"
+              << std::endl;
+    return false;
+#endif /* HAVE_BOOST_IOSTREAMS_ZSTD */
+  }
+  push(io::file_source(p_filename, std::ios::in | std::ios::binary));
+
+  return is_complete();
+}
+
+
+BlockBuffer::~BlockBuffer()
+{
+  if (is_open()) {
+    close();
+  }
+}
+
+
+bool BlockBuffer::open(const std::string &p_filename, codec_t p_codec, boost::uint32_t p_threads)
+{
+  if (is_open()) {
+    close();
+  }
+
+  m_file.open(p_filename.c_str(), std::ios::out | std::ios::binary);
+  if (!m_file.is_open()) {
+    return false;
+  }
+
+  m_codec = p_codec;
+  m_closing = false;
+  m_failed = false;
+  m_block.resize(BLOCK_SIZE);
+  setp(&m_block[0], &m_block[0] + m_block.size());
+
+  if (m_codec != PLAIN) {
+    for (boost::uint32_t t = 0; t < std::max<boost::uint32_t>(p_threads, 1); ++t) {
+      m_threads.push_back(std::thread(&BlockBuffer::run, this));
+    }
+  }
+
+  return true;
+}
+
+
+bool BlockBuffer::close()
+{
+  submit();
+
+  if (!m_threads.empty()) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_closing = true;
+    }
+    m_ready.notify_all();
+
+    for (std::vector<std::thread>::iterator it = m_threads.begin(); it != m_threads.end(); ++it) {
+      it->join();
+    }
+    m_threads.clear();
+  }
+
+  m_file.close();
+  setp(NULL, NULL);
+  std::vector<char>().swap(m_block);
+
+  return !m_failed && !m_file.fail();
+}
+
+
+BlockBuffer::int_type BlockBuffer::overflow(int_type p_c)
+{
+  submit();
+
+  if (!traits_type::eq_int_type(p_c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(p_c);
+    pbump(1);
+  }
+
+  return m_failed ? traits_type::eof() : traits_type::not_eof(p_c);
+}
+
+
+int BlockBuffer::sync()
+{
+  // the blocks are only cut when full, so that flushing the stream after every line stays cheap
+  return m_failed ? -1 : 0;
+}
+
+
+void BlockBuffer::submit()
+{
+  std::size_t n = pptr() - pbase();
+  if (n == 0) {
+    return;
+  }
+
+  if (m_codec == PLAIN) {
+    m_file.write(pbase(), n);
+    m_failed = m_failed || !m_file;
+  } else {
+    std::shared_ptr<block_t> block(new block_t);
+    block->data.swap(m_block);
+    block->data.resize(n);
+    m_block.resize(BLOCK_SIZE);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // at most two blocks per thread are in flight
+    while (m_queue.size() >= 2 * m_threads.size()) {
+      m_space.wait(lock);
+    }
+    m_queue.push_back(block);
+    m_ready.notify_one();
+  }
+
+  setp(&m_block[0], &m_block[0] + m_block.size());
+}
+
+
+void BlockBuffer::run()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  for (;;) {
+    // the oldest block that is not compressed yet
+    std::shared_ptr<block_t> block;
+    for (;;) {
+      for (std::deque<std::shared_ptr<block_t> >::iterator it = m_queue.begin(); it != m_queue.end(); ++it) {
+        if (!(*it)->taken) {
+          block = *it;
+          break;
+        }
+      }
+      if (block || m_closing) {
+        break;
+      }
+      m_ready.wait(lock);
+    }
+    if (!block) {
+      return;
+    }
+
+    block->taken = true;
+    lock.unlock();
+
+    bool compressed = true;
+    try {
+      compress(block->data, block->compressed);
+    } catch (std::exception &e) {
+      std::cerr << "Could not compress a block: " << e.what() << std::endl;
+      compressed = false;
+    }
+    std::vector<char>().swap(block->data);
+
+    lock.lock();
+    block->done = true;
+    m_failed = m_failed || !compressed;
+    drain();
+  }
+}
+
+
+void BlockBuffer::compress(const std::vector<char> &p_in, std::vector<char> &p_out) const
+{
+  p_out.clear();
+  p_out.reserve(p_in.size() / 2);
+
+  io::filtering_ostream os;
+  if (m_codec == GZIP) {
+    os.push(io::gzip_compressor());
+#ifdef HAVE_BOOST_IOSTREAMS_ZSTD
+  } else {
+    os.push(io::zstd_compressor());
+#endif /* HAVE_BOOST_IOSTREAMS_ZSTD */
+  }
+  os.push(io::back_inserter(p_out));
+  os.write(&p_in[0], p_in.size());
+
+  // closing the chain ends the gzip member or the zstd frame
+  os.reset();
+}
+
+
+void BlockBuffer::drain()
+{
+  // the blocks are written in order, by the thread completing the oldest one
+  while (!m_queue.empty() && m_queue.front()->done) {
+    const std::vector<char> &out = m_queue.front()->compressed;
+    if (!out.empty()) {
+      m_file.write(&out[0], out.size());
+    }
+    m_failed = m_failed || !m_file;
+    m_queue.pop_front();
+    m_space.notify_all();
+  }
+}
+
+
+bool OutputFile::open(const std::string &p_filename, codec_t p_codec, boost::uint32_t p_threads)
+{
+  clear();
+  return m_buffer.open(p_filename + extension(p_codec), p_codec, p_threads);
+}
+
+
+std::string OutputFile::extension(codec_t p_codec)
+{
+  switch (p_codec) {
+    case GZIP:
+      return ".gz";
+    case ZSTD:
+      return ".zst";
+    default:
+      return "";
+  }
+}
+
+
+bool OutputFile::codec(const std::string &p_name, codec_t &p_codec)
+{
+  if (p_name == "") {
+    p_codec = PLAIN;
+  } else if (p_name == "gzip") {
+    p_codec = GZIP;
+#ifdef HAVE_BOOST_IOSTREAMS_ZSTD
+  } else if (p_name == "zstd") {
+    p_codec = ZSTD;
+#endif /* HAVE_BOOST_IOSTREAMS_ZSTD */
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+
+}
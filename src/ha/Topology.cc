@@ -0,0 +1,198 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Topology.cc
+ * Implementation of the NUMA topology used to place the worker threads.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_SCHED_SETAFFINITY
+# include <sched.h>
+#endif /* HAVE_SCHED_SETAFFINITY */
+
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+
+#include "Topology.hh"
+
+namespace fs = boost::filesystem;
+
+
+namespace ha
+{
+
+
+/* the CPU the calling thread has been pinned to, if any */
+static thread_local boost::int64_t s_pinned = -1;
+
+
+bool Topology::parse(const std::string &p_list, std::vector<boost::uint32_t> &p_cpus)
+{
+  // a cpulist is a comma-separated list of CPUs and ranges of CPUs, e.g., 0-3,8-11
+  std::string list = boost::algorithm::trim_copy(p_list);
+  if (list.empty()) {
+    return true;
+  }
+
+  std::vector<std::string> ranges;
+  boost::split(ranges, list, boost::is_any_of(","));
+
+  try {
+    for (std::vector<std::string>::iterator it = ranges.begin(); it != ranges.end(); ++it) {
+      std::vector<std::string> bounds;
+      boost::split(bounds, *it, boost::is_any_of("-"));
+      boost::uint32_t first = boost::lexical_cast<boost::uint32_t>(bounds.front());
+      boost::uint32_t last = boost::lexical_cast<boost::uint32_t>(bounds.back());
+      for (boost::uint32_t cpu = first; cpu <= last; ++cpu) {
+        p_cpus.push_back(cpu);
+      }
+    }
+  } catch (boost::bad_lexical_cast &) {
+    std::cerr << "Could not parse the CPU list: " << list << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+bool Topology::load(const std::string &p_root)
+{
+  m_cpus.clear();
+  m_process.clear();
+
+#ifdef HAVE_SCHED_SETAFFINITY
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    std::cerr << "Could not read the CPUs of the process." << std::endl;
+    return false;
+  }
+  for (boost::uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &allowed)) {
+      m_process.push_back(cpu);
+    }
+  }
+
+  // the nodes are numbered consecutively from node0
+  for (boost::uint32_t n = 0; fs::is_directory(p_root + "/node" + boost::lexical_cast<std::string>(n)); ++n) {
+    std::string filename = p_root + "/node" + boost::lexical_cast<std::string>(n) + "/cpulist";
+    std::ifstream file(filename.c_str());
+    if (!file.is_open()) {
+      std::cerr << "Could not open file: " << filename << std::endl;
+      m_cpus.clear();
+      return false;
+    }
+
+    std::string line;
+    std::getline(file, line);
+    std::vector<boost::uint32_t> cpus, usable;
+    if (!parse(line, cpus)) {
+      m_cpus.clear();
+      return false;
+    }
+
+    for (std::vector<boost::uint32_t>::iterator it = cpus.begin(); it != cpus.end(); ++it) {
+      if (*it < CPU_SETSIZE && CPU_ISSET(*it, &allowed)) {
+        usable.push_back(*it);
+      }
+    }
+
+    // nodes without usable CPUs, e.g., memory-only nodes, cannot run workers
+    if (!usable.empty()) {
+      m_cpus.push_back(usable);
+    }
+  }
+
+  return !m_cpus.empty();
+#else
+  std::cerr << "Pinning threads is not supported on this platform." << std::endl;
+  return false;
+#endif /* HAVE_SCHED_SETAFFINITY */
+}
+
+
+bool Topology::pin(boost::uint32_t p_thread) const
+{
+  if (m_cpus.empty()) {
+    return false;
+  }
+
+  const std::vector<boost::uint32_t> &cpus = m_cpus[node(p_thread)];
+  boost::uint32_t cpu = cpus[(p_thread / nodes()) % cpus.size()];
+  if (s_pinned == cpu) {
+    return true;
+  }
+
+#ifdef HAVE_SCHED_SETAFFINITY
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+    return false;
+  }
+  s_pinned = cpu;
+
+  return true;
+#else
+  return false;
+#endif /* HAVE_SCHED_SETAFFINITY */
+}
+
+
+bool Topology::restore() const
+{
+  if (s_pinned < 0) {
+    return true;
+  }
+
+#ifdef HAVE_SCHED_SETAFFINITY
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (std::vector<boost::uint32_t>::const_iterator it = m_process.begin(); it != m_process.end(); ++it) {
+    CPU_SET(*it, &set);
+  }
+  if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+    return false;
+  }
+  s_pinned = -1;
+
+  return true;
+#else
+  return false;
+#endif /* HAVE_SCHED_SETAFFINITY */
+}
+
+
+}
@@ -0,0 +1,111 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file AggregateSink.hh
+ * Declaration of the aggregates of the scores of every query position.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __AGGREGATESINK_HH__
+#define __AGGREGATESINK_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <ostream>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "Aligner.hh"
+#include "SequenceSet.hh"
+
+
+namespace ha
+{
+
+
+/** @class AggregateSink
+ *
+ * This class reduces the scores of every query position against all
+ * target positions to their maximum, the first target position of the
+ * maximum, their mean, the number of scores at or above every
+ * threshold and a histogram of fixed bins, and writes them as one
+ * tab-separated line per query position. The scores are reduced per
+ * unique target, weighted by its multiplicity, by per-thread reducers
+ * merged in the order of the threads. The scores are passed on to the
+ * next sink, if any, e.g. the file of the score matrix.
+ */
+class AggregateSink : public ScoreSink, boost::noncopyable
+{
+ public:
+  /** @fn AggregateSink(std::ostream &p_out, ScoreSink *p_next, boost::uint32_t p_bins, double p_min, double p_max, const std::vector<double> &p_thresholds)
+   * @param std::ostream & the receiver of the aggregates
+   * @param ScoreSink * the sink the scores are passed on to, NULL for none
+   * @param boost::uint32_t the number of bins of the histogram
+   * @param double the lower bound of the first bin, smaller scores count into it
+   * @param double the upper bound of the last bin, larger scores count into it
+   * @param const std::vector<double> & the thresholds of the counts
+   */
+  AggregateSink(std::ostream &p_out, ScoreSink *p_next, boost::uint32_t p_bins, double p_min, double p_max,
+                const std::vector<double> &p_thresholds)
+      : m_out(p_out), m_next(p_next), m_bins(p_bins), m_min(p_min), m_max(p_max),
+        m_thresholds(p_thresholds), m_targets(NULL)
+  {}
+  ~AggregateSink() {}
+
+  void write(boost::uint32_t p_pos, SequenceSet &p_targets, const std::vector<double> &p_scores);
+
+ private:
+  /** @struct summary_t
+   * structure holding the reduced scores of a query position.
+   */
+  struct summary_t {
+    double max;                                 /* maximum score */
+    boost::uint32_t argmax;                     /* first target position of the maximum */
+    double sum;                                 /* sum of the scores */
+    boost::uint64_t count;                      /* number of scores */
+    std::vector<boost::uint64_t> above;         /* number of scores at or above every threshold */
+    std::vector<boost::uint64_t> bins;          /* histogram of the scores */
+  };
+
+  void index(SequenceSet &p_targets);
+  void reset(summary_t &p_summary) const;
+  void add(summary_t &p_summary, boost::uint32_t p_v, double p_score) const;
+  void merge(summary_t &p_summary, const summary_t &p_other) const;
+
+  std::ostream &m_out;
+  ScoreSink *m_next;
+  boost::uint32_t m_bins;
+  double m_min;
+  double m_max;
+  std::vector<double> m_thresholds;
+  SequenceSet *m_targets;
+  std::vector<boost::uint32_t> m_first;       /* first target position of every unique target */
+  std::vector<summary_t> m_partial;           /* reducers of the threads */
+};
+
+
+}
+
+
+#endif
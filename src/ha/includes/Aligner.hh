@@ -0,0 +1,419 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Aligner.hh
+ * Declaration of the batch alignment of sets of sequences.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __ALIGNER_HH__
+#define __ALIGNER_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "AbstractDistanceMeasure.hh"
+#include "MemoryPool.hh"
+#include "SimilarityAlgorithm.hh"
+#include "Sweep.hh"
+#include "Wavefront.hh"
+
+#include "AlignmentWriter.hh"
+#include "FrontierStore.hh"
+#include "Hierarchy.hh"
+#include "MinHash.hh"
+#include "PrefixTrie.hh"
+#include "SequenceSet.hh"
+#include "Topology.hh"
+#include "TreePathSimilarityMeasure.hh"
+#include "Types.hh"
+
+
+namespace ha
+{
+
+
+/** @struct alignOptions
+ * structure specifying the configuration of the alignments.
+ */
+struct alignOptions {
+  boost::int32_t alg;             /* The similarity algorithm to use: 1-SW, 2-NW, 3-SW and NW scores, 4-approximate SW */
+  bool scores;                    /* Indicate whether only scores should be computed */
+  double gap_penalty;             /* gap penalty */
+  bool rle;                       /* Indicate whether the scores are computed on runs of symbols */
+  boost::int32_t norm;            /* The normalisation of the scores: 1-squared min, 2-max length, 3-self scores, 4-raw */
+  boost::uint32_t seed_k;         /* length of the seeds, 0 disables the seed filter */
+  boost::uint32_t seed_level;     /* level of the hierarchy the seeds are projected onto */
+  boost::uint32_t seed_min;       /* minimum number of shared seeds of a candidate pair */
+  boost::uint32_t coarse_level;   /* level of the coarse alignments, 0 disables them */
+  double coarse_min;              /* minimum normalised coarse score of a candidate pair */
+  double xdrop;                   /* X-drop of the local alignments, 0 computes the whole matrices */
+  bool numa;                      /* Indicate whether the workers are pinned to NUMA nodes with local replicas */
+  boost::int32_t huge_pages;      /* The pages of the matrices and score tables: 0-small, 1-transparent huge, 2-explicit huge */
+  boost::uint64_t dp_cap;         /* bytes of the matrices of a worker, 0 for no limit */
+  std::vector<double> sweep;      /* gap penalties scored in one pass, empty for just the gap penalty */
+  boost::uint32_t sketch_k;       /* length of the k-mers of the sketches */
+  boost::uint32_t sketch_size;    /* number of hashes of a sketch */
+  boost::uint32_t sketch_sample;  /* number of pairs aligned to calibrate the approximate scores */
+  bool trie;                      /* Indicate whether the rows of common prefixes of the queries are shared */
+  boost::uint64_t wavefront;      /* cells of a pair computed by all workers together, 0 for none */
+  boost::uint32_t wavefront_tile; /* rows and columns of the tiles of such a pair */
+  boost::uint64_t row_cache;      /* bytes of the rows of repeated queries kept for their next positions, 0 for no limit */
+
+  alignOptions()
+      : alg(1), scores(0), gap_penalty(1.33), rle(0), norm(1), seed_k(0), seed_level(1), seed_min(1),
+        coarse_level(0), coarse_min(0.5), xdrop(0.0), numa(0), huge_pages(0), dp_cap(0), sweep(),
+        sketch_k(2), sketch_size(128), sketch_sample(1000), trie(0),
+        wavefront(0), wavefront_tile(256), row_cache(0)
+  {}
+};
+
+
+/** @struct alignStats
+ * structure counting the pairs of the last batch.
+ */
+struct alignStats {
+  boost::uint64_t pairs;          /* unique pairs of the batch */
+  boost::uint64_t candidates;     /* unique pairs passing the seed filter */
+  boost::uint64_t coarseFiltered; /* candidates filtered at the coarse level */
+  boost::uint64_t skippedCells;   /* cells of the full alignments skipped by the X-drop */
+  boost::uint64_t cappedPairs;    /* pairs scored in linear space, because their matrices exceeded the cap */
+  boost::uint64_t sampledPairs;   /* pairs aligned to calibrate the approximate scores */
+  boost::uint64_t approximatedPairs; /* pairs scored by their sketches instead of being aligned */
+  double sampleMeanError;         /* mean absolute error of the approximate scores of the held-out sampled pairs */
+  double sampleRmsError;          /* root mean squared error of the approximate scores of the held-out sampled pairs */
+  double sampleP95Error;          /* 95th percentile of the absolute errors of the held-out sampled pairs */
+  boost::uint64_t sharedRows;     /* rows of the matrices not computed, because the queries share their prefixes */
+  boost::uint64_t reusedCells;    /* cells of the matrices not computed, because the previous frontiers cover them */
+  boost::uint64_t wavefrontPairs; /* pairs computed by all workers together */
+  boost::uint64_t recomputedRows; /* rows of repeated queries computed again, because they exceeded the row cache */
+
+  alignStats()
+      : pairs(0), candidates(0), coarseFiltered(0), skippedCells(0), cappedPairs(0),
+        sampledPairs(0), approximatedPairs(0), sampleMeanError(0.0), sampleRmsError(0.0), sampleP95Error(0.0),
+        sharedRows(0), reusedCells(0), wavefrontPairs(0), recomputedRows(0)
+  {}
+};
+
+
+/** @class ScoreSink
+ *
+ * This class declares the interface receiving the normalised scores
+ * of a batch. The scores of every position of the query set are
+ * delivered in order and are indexed by the unique IDs of the targets.
+ */
+class ScoreSink
+{
+ public:
+  ScoreSink() {}
+  virtual ~ScoreSink() {}
+
+  /** @fn void write(boost::uint32_t p_pos, SequenceSet &p_targets, const std::vector<double> &p_scores)
+   * @param boost::uint32_t the position of the query in its set
+   * @param SequenceSet & the targets
+   * @param const std::vector<double> & the scores indexed by the unique IDs of the targets
+   */
+  virtual void write(boost::uint32_t p_pos, SequenceSet &p_targets, const std::vector<double> &p_scores) = 0;
+};
+
+
+/** @class ScoreMatrix
+ *
+ * This class collects the scores of a batch in a dense matrix indexed
+ * by the positions of the queries and the targets in their sets.
+ */
+class ScoreMatrix : public ScoreSink
+{
+ public:
+  ScoreMatrix() {}
+  ~ScoreMatrix() {}
+
+  void write(boost::uint32_t p_pos, SequenceSet &p_targets, const std::vector<double> &p_scores)
+  {
+    if (p_pos >= m_scores.size()) {
+      m_scores.resize(p_pos + 1);
+    }
+    m_scores[p_pos].resize(p_targets.size());
+    for (boost::uint32_t j = 0; j < p_targets.size(); ++j) {
+      m_scores[p_pos][j] = p_scores[p_targets.id(j)];
+    }
+  }
+
+  std::vector<std::vector<double> > & scores()
+  {
+    return m_scores;
+  }
+
+ private:
+  std::vector<std::vector<double> > m_scores;
+};
+
+
+/** @class TopKSink
+ *
+ * This class keeps the k best scoring target positions of every query
+ * position. Ties are broken by the position of the target.
+ */
+class TopKSink : public ScoreSink
+{
+ public:
+  typedef std::pair<boost::uint32_t, double> match_t;
+
+  TopKSink(boost::uint32_t p_k) : m_k(p_k) {}
+  ~TopKSink() {}
+
+  void write(boost::uint32_t p_pos, SequenceSet &p_targets, const std::vector<double> &p_scores)
+  {
+    if (p_pos >= m_matches.size()) {
+      m_matches.resize(p_pos + 1);
+    }
+
+    std::vector<match_t> &matches = m_matches[p_pos];
+    matches.resize(p_targets.size());
+    for (boost::uint32_t j = 0; j < p_targets.size(); ++j) {
+      matches[j] = std::make_pair(j, p_scores[p_targets.id(j)]);
+    }
+
+    std::vector<match_t>::iterator last = matches.begin() + std::min<std::size_t>(m_k, matches.size());
+    std::partial_sort(matches.begin(), last, matches.end(), [](const match_t &a, const match_t &b) {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+      });
+    matches.erase(last, matches.end());
+  }
+
+  /** @return the best matches of the query at the given position in descending order of their scores */
+  const std::vector<match_t> & matches(boost::uint32_t p_pos) const
+  {
+    return m_matches[p_pos];
+  }
+
+  void clear()
+  {
+    m_matches.clear();
+  }
+
+ private:
+  boost::uint32_t m_k;
+  std::vector<std::vector<match_t> > m_matches;
+};
+
+
+/** @class Aligner
+ *
+ * This class aligns batches of query sequences against target
+ * sequences over a loaded hierarchy. The OpenMP worker threads keep
+ * their own memory pools for the dynamic programming matrices across
+ * batches, so that repeated batches within one process neither reparse
+ * the inputs nor reallocate the matrices.
+ */
+class Aligner : boost::noncopyable
+{
+ public:
+  Aligner(Hierarchy &p_hierarchy, const alignOptions &p_options);
+
+  /** @fn Aligner(Hierarchy &p_hierarchy, const alignOptions &p_options, const boost::shared_ptr<const TreePathSimilarityMeasure> &p_scheme)
+   * Align with a scoring scheme built by createScheme() for the same
+   * hierarchy and gap penalty, so that several aligners share its table.
+   */
+  Aligner(Hierarchy &p_hierarchy, const alignOptions &p_options,
+          const boost::shared_ptr<const TreePathSimilarityMeasure> &p_scheme);
+  ~Aligner();
+
+  /** @fn static boost::shared_ptr<const TreePathSimilarityMeasure> createScheme(Hierarchy &p_hierarchy, const alignOptions &p_options)
+   * Build the scoring scheme of a hierarchy with the gap penalty of the
+   * options. The pages of the options apply to its table and to the
+   * matrices allocated from then on.
+   */
+  static boost::shared_ptr<const TreePathSimilarityMeasure> createScheme(Hierarchy &p_hierarchy, const alignOptions &p_options);
+
+  /** @fn void index(SequenceSet &p_targets)
+   * Prepare the targets for repeated batches against them. The seed
+   * index, the coarse sequences and the self-alignment scores of the
+   * targets are kept until the next targets are indexed. The targets
+   * have to outlive their use by the aligner.
+   *
+   * @param SequenceSet & the target sequences
+   */
+  void index(SequenceSet &p_targets);
+
+  /** @fn void align(SequenceSet &p_queries, ScoreSink &p_sink)
+   * Align all unique queries against all unique indexed targets and
+   * deliver the normalised scores of every position of the query set to
+   * the sink. Of a sweep, only the scores of the first lane are delivered.
+   *
+   * @param SequenceSet & the query sequences
+   * @param ScoreSink & the receiver of the scores
+   */
+  void align(SequenceSet &p_queries, ScoreSink &p_sink)
+  {
+    std::vector<ScoreSink*> sinks(lanes(), NULL);
+    sinks[0] = &p_sink;
+    align(p_queries, sinks);
+  }
+
+  /** @fn void align(SequenceSet &p_queries, const std::vector<ScoreSink*> &p_sinks)
+   * Align all unique queries against all unique indexed targets and
+   * deliver the normalised scores of every lane of the sweep to its own
+   * sink.
+   *
+   * @param SequenceSet & the query sequences
+   * @param const std::vector<ScoreSink*> & the receivers of the scores, one per lane, NULL to drop a lane
+   */
+  void align(SequenceSet &p_queries, const std::vector<ScoreSink*> &p_sinks);
+
+  /** @fn void align(SequenceSet &p_queries, SequenceSet &p_targets, ScoreSink &p_sink)
+   * Index the targets and align the queries against them.
+   */
+  void align(SequenceSet &p_queries, SequenceSet &p_targets, ScoreSink &p_sink)
+  {
+    index(p_targets);
+    align(p_queries, p_sink);
+  }
+
+  /** @fn void extend(SequenceSet &p_queries, const FrontierStore *p_previous, FrontierStore &p_next, ScoreSink &p_sink)
+   * Align all unique queries against all unique indexed targets by
+   * extending the frontiers of the pairs of their previous sequences,
+   * keep the frontiers of the pairs for the next run and deliver the
+   * normalised scores of every position of the query set to the sink.
+   * Pairs without previous sequences are aligned from scratch. Only
+   * computes the scores of SW and NW.
+   *
+   * @param SequenceSet & the query sequences
+   * @param const FrontierStore * the frontiers of the previous run, NULL to align all pairs from scratch
+   * @param FrontierStore & the frontiers of the queries and the indexed targets
+   * @param ScoreSink & the receiver of the scores
+   */
+  void extend(SequenceSet &p_queries, const FrontierStore *p_previous, FrontierStore &p_next, ScoreSink &p_sink);
+
+  /** @fn alignment::alignmentResult align(common::StringVec &p_a, common::StringVec &p_b)
+   * Align a single pair of sequences, including the traceback if
+   * configured. The traceback is valid until the next single pair is
+   * aligned.
+   */
+  alignment::alignmentResult align(common::StringVec &p_a, common::StringVec &p_b);
+
+  /** @fn void materialise(const alignment::alignmentResult &p_res, common::StringVec &p_a, common::StringVec &p_b, common::StringVec &p_consensus_a, common::StringVec &p_consensus_b)
+   * Expand the traceback of the last single pair into the consensus of both sequences.
+   */
+  void materialise(const alignment::alignmentResult &p_res, common::StringVec &p_a, common::StringVec &p_b,
+                   common::StringVec &p_consensus_a, common::StringVec &p_consensus_b);
+
+  /** @fn void traces(TraceSink *p_sink)
+   * Deliver the tracebacks of the aligned pairs of the following batches
+   * to the sink, or to no sink if NULL. Requires the alignments to be
+   * computed, i.e., not just the scores. The pairs exceeding the cap of
+   * the matrices have no traceback and are not delivered.
+   */
+  void traces(TraceSink *p_sink)
+  {
+    m_traceSink = p_sink;
+  }
+
+  /** @return the number of score matrices of a batch, one per algorithm and gap penalty of the sweep */
+  boost::uint32_t lanes() const
+  {
+    return m_sweep ? m_sweep->lanes() : 1;
+  }
+
+  /** @return the algorithm and gap penalty of the k-th score matrix of a sweep */
+  const alignment::lane_t & lane(boost::uint32_t k) const
+  {
+    return m_sweep->lane(k);
+  }
+
+  /** @return the scoring scheme, whose symbol IDs are used by the LCAs of the tracebacks */
+  const TreePathSimilarityMeasure & scheme() const
+  {
+    return *m_scoringScheme;
+  }
+
+  /** @return the NUMA topology the workers are placed on */
+  const Topology & topology() const
+  {
+    return m_topology;
+  }
+
+  /** @return the counts of the last batch */
+  const alignStats & stats() const
+  {
+    return m_stats;
+  }
+
+ private:
+  struct batch_t;
+  struct replica_t;
+  struct targets_t;
+
+  alignment::SimilarityAlgorithm * algorithm(bool p_justscores, double p_xdrop = 0.0) const;
+  void selfScores(common::Sequences &p_seqs, std::vector<double> &p_scores);
+  void sketch(common::Sequences &p_seqs, std::vector<MinHash::sketch_t> &p_sketches);
+  template <typename Normaliser>
+  void calibrate(batch_t &p_batch);
+  template <typename Normaliser>
+  void alignTrie(batch_t &p_batch, const PrefixTrie &p_trie, std::vector<double> &p_scores);
+  template <typename Normaliser>
+  void extendPairs(batch_t &p_batch, const FrontierStore *p_previous, const std::vector<boost::uint32_t> &p_prev_1,
+                   const std::vector<boost::uint32_t> &p_prev_2, FrontierStore &p_next, std::vector<double> &p_scores);
+  template <typename Normaliser>
+  boost::uint64_t alignRow(batch_t &p_batch, boost::uint32_t p_u, std::vector<boost::uint32_t> &p_candidates,
+                           std::vector<std::vector<double> > &p_rows);
+  void init();
+  alignment::MemoryPool & pool();
+  boost::uint32_t worker() const;
+  boost::uint32_t workers() const;
+  void place() const;
+  void release() const;
+  bool tiles(const alignment::MemoryPool &p_mem, boost::uint32_t p_a, boost::uint32_t p_b) const;
+  replica_t & replica();
+  void reservePools();
+  void encode(common::Sequences &p_seqs, std::vector<std::vector<boost::uint32_t> > &p_ids) const;
+  void lcas(const alignment::trace_t &p_trace, const alignment::TraceArena &p_arena,
+            const std::vector<boost::uint32_t> &p_a, const std::vector<boost::uint32_t> &p_b,
+            std::vector<boost::uint32_t> &p_lcas) const;
+
+  Hierarchy &m_hierarchy;
+  alignOptions m_options;
+  Topology m_topology;
+  alignStats m_stats;
+  boost::shared_ptr<const TreePathSimilarityMeasure> m_scoringScheme;
+  boost::scoped_ptr<alignment::SimilarityAlgorithm> m_similarity;
+  boost::scoped_ptr<alignment::Sweep> m_sweep;
+  boost::scoped_ptr<MinHash> m_minhash;
+  std::vector<alignment::MemoryPool> m_pools;
+  boost::scoped_ptr<targets_t> m_targets;
+  TraceSink *m_traceSink;
+};
+
+
+}
+
+
+#endif
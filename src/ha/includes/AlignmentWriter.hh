@@ -0,0 +1,139 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file AlignmentWriter.hh
+ * Declaration of the streamed output of the alignments of a batch.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __ALIGNMENTWRITER_HH__
+#define __ALIGNMENTWRITER_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "SimilarityAlgorithm.hh"
+#include "Trace.hh"
+
+#include "SequenceSet.hh"
+
+
+namespace ha
+{
+
+
+/** @class TraceSink
+ *
+ * This class declares the interface receiving the tracebacks of the
+ * aligned unique pairs of a batch. The pairs are delivered by the
+ * worker threads concurrently and in no particular order.
+ */
+class TraceSink
+{
+ public:
+  TraceSink() {}
+  virtual ~TraceSink() {}
+
+  /** @fn void begin(SequenceSet &p_queries, SequenceSet &p_targets)
+   * Start a batch of the given sets.
+   */
+  virtual void begin(SequenceSet &p_queries, SequenceSet &p_targets) = 0;
+
+  /** @fn void write(boost::uint32_t p_u, boost::uint32_t p_v, double p_score, const alignment::alignmentResult &p_res, const alignment::TraceArena &p_arena, const std::vector<boost::uint32_t> &p_lcas)
+   * @param boost::uint32_t the unique ID of the query
+   * @param boost::uint32_t the unique ID of the target
+   * @param double the normalised score
+   * @param const alignment::alignmentResult & the raw score and the traceback
+   * @param const alignment::TraceArena & the arena of the traceback
+   * @param const std::vector<boost::uint32_t> & the IDs of the LCAs of the aligned symbols
+   */
+  virtual void write(boost::uint32_t p_u, boost::uint32_t p_v, double p_score, const alignment::alignmentResult &p_res,
+                     const alignment::TraceArena &p_arena, const std::vector<boost::uint32_t> &p_lcas) = 0;
+
+  /** @fn void end()
+   * Finish a batch; all its pairs have been written when this returns.
+   */
+  virtual void end() = 0;
+};
+
+
+/** @class AlignmentWriter
+ *
+ * This class streams the tracebacks of a batch to a file. The worker
+ * threads only encode their records into buffers of their own. Full
+ * buffers are handed to a dedicated writer thread, which fans every
+ * unique pair out to the positions of both sets and formats the
+ * records as tab-separated text or as binary.
+ */
+class AlignmentWriter : public TraceSink, boost::noncopyable
+{
+ public:
+  /** size of the buffers handed to the writer thread */
+  static const std::size_t BUFFER_SIZE = 1 << 20;
+
+  /** number of full buffers the writer thread may lag behind */
+  static const std::size_t QUEUE_SIZE = 64;
+
+  AlignmentWriter(std::ostream &p_out, bool p_binary);
+  ~AlignmentWriter();
+
+  void begin(SequenceSet &p_queries, SequenceSet &p_targets);
+  void write(boost::uint32_t p_u, boost::uint32_t p_v, double p_score, const alignment::alignmentResult &p_res,
+             const alignment::TraceArena &p_arena, const std::vector<boost::uint32_t> &p_lcas);
+  void end();
+
+ private:
+  void submit(std::vector<char> &p_buffer);
+  void run();
+  void format(const std::vector<char> &p_buffer);
+
+  std::ostream &m_out;
+  bool m_binary;
+  std::vector<std::vector<boost::uint32_t> > m_positions_1;   /* positions of the unique queries */
+  std::vector<std::vector<boost::uint32_t> > m_positions_2;   /* positions of the unique targets */
+  std::vector<std::vector<char> > m_buffers;                  /* buffers of the worker threads */
+  std::deque<std::vector<char> > m_queue;                     /* full buffers waiting for the writer */
+  std::vector<std::vector<char> > m_free;                     /* written buffers for reuse */
+  bool m_busy;
+  bool m_done;
+  std::mutex m_mutex;
+  std::condition_variable m_ready;
+  std::condition_variable m_space;
+  std::condition_variable m_idle;
+  std::thread m_thread;
+};
+
+
+}
+
+
+#endif
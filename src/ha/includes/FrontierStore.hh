@@ -0,0 +1,142 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file FrontierStore.hh
+ * Declaration of the memory-mapped store of the frontiers of all pairs of two sets.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __FRONTIERSTORE_HH__
+#define __FRONTIERSTORE_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "SequenceSet.hh"
+
+
+namespace ha
+{
+
+
+/** @class FrontierStore
+ *
+ * This class keeps the frontiers (see alignment::Frontier) of all pairs
+ * of unique sequences of two sets in a memory-mapped file. Next to the
+ * frontiers, the file records the unique ID of every position of both
+ * sets and the length and the hash of every unique sequence, so that a
+ * later run can find the previous sequence every sequence grew from.
+ * The frontiers of a unique query against all unique targets are
+ * consecutive, and their offsets follow from the lengths.
+ */
+class FrontierStore : boost::noncopyable
+{
+ public:
+  /** the unique ID of a sequence without a previous sequence */
+  static const boost::uint32_t NONE = 0xffffffff;
+
+  FrontierStore() : m_data(NULL) {}
+  ~FrontierStore()
+  {
+    close();
+  }
+
+  /** @fn bool open(const std::string &p_filename)
+   * Map the frontiers of a previous run read-only.
+   *
+   * @return true, if the file could be mapped. Otherwise the error is reported on std::cerr.
+   */
+  bool open(const std::string &p_filename);
+
+  /** @fn bool create(const std::string &p_filename, SequenceSet &p_set_1, SequenceSet &p_set_2)
+   * Create the file of the frontiers of all pairs of the unique sequences of both sets and map it writable.
+   *
+   * @return true, if the file could be created. Otherwise the error is reported on std::cerr.
+   */
+  bool create(const std::string &p_filename, SequenceSet &p_set_1, SequenceSet &p_set_2);
+
+  void close();
+
+  /** @fn void match(SequenceSet &p_set, boost::uint32_t p_side, std::vector<boost::uint32_t> &p_prev) const
+   * Find the previous sequence of every unique sequence of a set. The
+   * previous sequence at the same position is the previous sequence,
+   * if it is a prefix of the sequence. Of several candidates the
+   * longest is taken, sequences without a candidate map to NONE.
+   *
+   * @param SequenceSet & the sequences of this run
+   * @param boost::uint32_t the set the sequences replace: 0 - set 1, 1 - set 2
+   * @param std::vector<boost::uint32_t> & the previous unique ID per unique ID of the set
+   */
+  void match(SequenceSet &p_set, boost::uint32_t p_side, std::vector<boost::uint32_t> &p_prev) const;
+
+  /** @return the length of a unique sequence of a set */
+  boost::uint32_t length(boost::uint32_t p_side, boost::uint32_t p_u) const
+  {
+    return m_lengths[p_side][p_u];
+  }
+
+  /** @return the frontier of a pair of unique sequences */
+  const double * frontier(boost::uint32_t p_u, boost::uint32_t p_v) const
+  {
+    return m_data + offset(p_u, p_v);
+  }
+
+  double * frontier(boost::uint32_t p_u, boost::uint32_t p_v)
+  {
+    return m_data + offset(p_u, p_v);
+  }
+
+  /** @fn static boost::uint64_t hash(const common::StringVec &p_seq, boost::uint32_t p_len)
+   * @return the 64-bit FNV-1a hash of the first symbols of a sequence, the same as of the fingerprints
+   */
+  static boost::uint64_t hash(const common::StringVec &p_seq, boost::uint32_t p_len);
+
+ private:
+  bool layout(const std::string &p_filename);
+
+  boost::uint64_t offset(boost::uint32_t p_u, boost::uint32_t p_v) const
+  {
+    return m_base[p_u] + m_cum[p_v] + static_cast<boost::uint64_t>(p_v) * (m_lengths[0][p_u] + 2);
+  }
+
+  boost::iostreams::mapped_file m_file;
+  boost::uint32_t m_positions[2];
+  boost::uint32_t m_unique[2];
+  const boost::uint32_t *m_ids[2];
+  const boost::uint32_t *m_lengths[2];
+  const boost::uint64_t *m_hashes[2];
+  std::vector<boost::uint64_t> m_base;
+  std::vector<boost::uint64_t> m_cum;
+  double *m_data;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,104 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Hierarchy.hh
+ * Declaration of the hierarchical classification scheme of the alphabet.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __HIERARCHY_HH__
+#define __HIERARCHY_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <string>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include "HierarchyProjection.hh"
+#include "Types.hh"
+
+
+namespace ha
+{
+
+
+/** @class Hierarchy
+ *
+ * This class keeps the Euler circuit and the offline LCAs of the
+ * hierarchical classification scheme of the alphabet. It is loaded
+ * once and shared by all alignments against it.
+ */
+class Hierarchy : boost::noncopyable
+{
+ public:
+  Hierarchy() {}
+  ~Hierarchy() {}
+
+  /** @fn bool load(const std::string &p_levels, const std::string &p_positions, const std::string &p_lca)
+   * Load the Euler levels, the Euler positions and the LCAs from their files.
+   *
+   * @param const std::string & the filename of the vertex levels in the Euler circuit
+   * @param const std::string & the filename of the vertex positions in the Euler circuit
+   * @param const std::string & the filename of the LCAs computed offline
+   * @return true, if all files could be parsed. Otherwise the error is reported on std::cerr.
+   */
+  bool load(const std::string &p_levels, const std::string &p_positions, const std::string &p_lca);
+
+  common::DoubleVec & levels()
+  {
+    return m_levels;
+  }
+
+  common::StringIntMap & positions()
+  {
+    return m_positions;
+  }
+
+  common::StrStrMap & lcas()
+  {
+    return m_lcas;
+  }
+
+  /** @return the projection of symbols onto their ancestors, available after loading */
+  const HierarchyProjection & projection() const
+  {
+    return *m_projection;
+  }
+
+ private:
+  bool loadLevels(const std::string &p_filename);
+  bool loadPositions(const std::string &p_filename);
+  bool loadLcas(const std::string &p_filename);
+
+  common::DoubleVec m_levels;
+  common::StringIntMap m_positions;
+  common::StrStrMap m_lcas;
+  boost::scoped_ptr<HierarchyProjection> m_projection;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,198 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file HierarchyProjection.hh
+ * Declaration and implementation of the projection of symbols onto their ancestors.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __HIERARCHYPROJECTION_HH__
+#define __HIERARCHYPROJECTION_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "Types.hh"
+
+
+namespace ha
+{
+
+
+/** @class HierarchyProjection
+ *
+ * This class projects symbols of the hierarchical alphabet onto their
+ * ancestors at a given level using the Euler circuit only. The
+ * ancestor at level L of a symbol is the vertex of level L whose first
+ * occurrence in the Euler circuit is the last one before the first
+ * occurrence of the symbol itself, because the vertices of one level
+ * are visited in pre-order and cannot nest. The level of the least
+ * common ancestor of two symbols is the minimum level between their
+ * first occurrences, which is answered by a sparse table in constant
+ * time.
+ */
+class HierarchyProjection
+{
+ public:
+  HierarchyProjection(const common::DoubleVec &p_levels, const common::StringIntMap &p_pos)
+      : m_levels(p_levels), m_pos(p_pos)
+  {
+    for (common::StringIntMap::const_iterator it = m_pos.begin(); it != m_pos.end(); ++it) {
+      boost::uint32_t level = m_levels[it->second];
+      if (level >= m_byLevel.size()) {
+        m_byLevel.resize(level + 1);
+      }
+      m_byLevel[level].push_back(std::make_pair(it->second, it->first));
+    }
+
+    for (std::vector<Vertices>::iterator it = m_byLevel.begin(); it != m_byLevel.end(); ++it) {
+      std::sort(it->begin(), it->end(), [](const Vertex &a, const Vertex &b) { return a.first < b.first; });
+    }
+
+    // sparse table of the range minima over the Euler levels
+    m_rmq.push_back(std::vector<boost::uint32_t>(m_levels.begin(), m_levels.end()));
+    for (std::size_t width = 2; width <= m_levels.size(); width *= 2) {
+      const std::vector<boost::uint32_t> &prev = m_rmq.back();
+      std::vector<boost::uint32_t> next(m_levels.size() - width + 1);
+      for (std::size_t i = 0; i < next.size(); ++i) {
+        next[i] = std::min(prev[i], prev[i + width / 2]);
+      }
+      m_rmq.push_back(next);
+    }
+  }
+
+  ~HierarchyProjection() {}
+
+  /** @fn boost::uint32_t level(const common::Symbol &p_sym) const
+   * @return the level of the symbol in the hierarchy or 0 for unknown symbols.
+   */
+  boost::uint32_t level(const common::Symbol &p_sym) const
+  {
+    common::StringIntMap::const_iterator it = m_pos.find(p_sym);
+    return (it == m_pos.end()) ? 0 : m_levels[it->second];
+  }
+
+  /** @return the deepest level of the hierarchy */
+  boost::uint32_t depth() const
+  {
+    return m_byLevel.empty() ? 0 : m_byLevel.size() - 1;
+  }
+
+  /** @fn bool contains(const common::Symbol &p_sym) const
+   * @return true, if the symbol is a vertex of the hierarchy.
+   */
+  bool contains(const common::Symbol &p_sym) const
+  {
+    return m_pos.find(p_sym) != m_pos.end();
+  }
+
+  /** @fn boost::uint32_t lcaLevel(const common::Symbol &p_a, const common::Symbol &p_b) const
+   * @return the level of the least common ancestor of two known symbols.
+   */
+  boost::uint32_t lcaLevel(const common::Symbol &p_a, const common::Symbol &p_b) const
+  {
+    boost::uint32_t lo = m_pos.find(p_a)->second;
+    boost::uint32_t hi = m_pos.find(p_b)->second;
+    if (lo > hi) {
+      std::swap(lo, hi);
+    }
+
+    std::size_t k = 0;
+    while ((static_cast<std::size_t>(2) << k) <= hi - lo + 1) {
+      ++k;
+    }
+
+    return std::min(m_rmq[k][lo], m_rmq[k][hi + 1 - (static_cast<std::size_t>(1) << k)]);
+  }
+
+  /** @fn common::Symbol project(const common::Symbol &p_sym, boost::uint32_t p_level) const
+   * Project a symbol onto its ancestor at the given level. Symbols at
+   * or above this level as well as unknown symbols project onto
+   * themselves.
+   *
+   * @param const common::Symbol & the symbol to project
+   * @param boost::uint32_t the level of the ancestor
+   * @return the ancestor of the symbol
+   */
+  common::Symbol project(const common::Symbol &p_sym, boost::uint32_t p_level) const
+  {
+    common::StringIntMap::const_iterator it = m_pos.find(p_sym);
+    if (it == m_pos.end() || m_levels[it->second] <= p_level) {
+      return p_sym;
+    }
+
+    const Vertices &vertices = m_byLevel[p_level];
+    Vertices::const_iterator anc = std::upper_bound(
+        vertices.begin(), vertices.end(), it->second,
+        [](boost::uint32_t pos, const Vertex &v) { return pos < v.first; });
+
+    return (anc == vertices.begin()) ? p_sym : (anc - 1)->second;
+  }
+
+  /** @fn void project(const common::StringVec &p_seq, boost::uint32_t p_level, common::StringVec &p_projected) const
+   * Project every symbol of a sequence onto its ancestor at the given level.
+   */
+  void project(const common::StringVec &p_seq, boost::uint32_t p_level, common::StringVec &p_projected) const
+  {
+    p_projected.clear();
+    p_projected.reserve(p_seq.size());
+    for (common::StringVec::const_iterator it = p_seq.begin(); it != p_seq.end(); ++it) {
+      p_projected.push_back(project(*it, p_level));
+    }
+  }
+
+  /** @fn void coarsen(const common::StringVec &p_seq, boost::uint32_t p_level, common::StringVec &p_coarse) const
+   * Project a sequence onto the given level and collapse the runs of
+   * identical ancestors into a single symbol.
+   */
+  void coarsen(const common::StringVec &p_seq, boost::uint32_t p_level, common::StringVec &p_coarse) const
+  {
+    p_coarse.clear();
+    for (common::StringVec::const_iterator it = p_seq.begin(); it != p_seq.end(); ++it) {
+      common::Symbol anc = project(*it, p_level);
+      if (p_coarse.empty() || p_coarse.back() != anc) {
+        p_coarse.push_back(anc);
+      }
+    }
+  }
+
+ private:
+  typedef std::pair<boost::uint32_t, common::Symbol> Vertex;
+  typedef std::vector<Vertex> Vertices;
+
+  const common::DoubleVec &m_levels;
+  const common::StringIntMap &m_pos;
+  std::vector<Vertices> m_byLevel;
+  std::vector<std::vector<boost::uint32_t> > m_rmq;
+};
+
+
+}
+
+
+#endif
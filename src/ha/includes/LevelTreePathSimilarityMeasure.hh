@@ -0,0 +1,94 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file LevelTreePathSimilarityMeasure.hh
+ * Declaration of the tree-based path similarity scoring scheme restricted to a level of the hierarchy.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __LEVELTREEPATHSIMILARITYMEASURE_HH__
+#define __LEVELTREEPATHSIMILARITYMEASURE_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <boost/cstdint.hpp>
+
+#include "AbstractDistanceMeasure.hh"
+#include "HierarchyProjection.hh"
+#include "Types.hh"
+
+
+namespace ha
+{
+
+
+/** @class LevelTreePathSimilarityMeasure
+ *
+ * This class implements the tree path similarity for symbols projected
+ * onto their ancestors at a given level. The internal vertices of the
+ * hierarchy are not necessarily covered by the LCA table computed
+ * offline, so the level of the LCA is taken from the Euler circuit.
+ */
+class LevelTreePathSimilarityMeasure : public alignment::AbstractDistanceMeasure
+{
+ public:
+  LevelTreePathSimilarityMeasure(double p_delta, const HierarchyProjection &p_proj, boost::uint32_t p_level)
+      : alignment::AbstractDistanceMeasure(p_delta), m_proj(p_proj), m_level(p_level) {}
+
+  ~LevelTreePathSimilarityMeasure() {}
+
+  double d(const common::Symbol &a, const common::Symbol &b) const
+  {
+    common::Symbol left = m_proj.project(a, m_level);
+    common::Symbol right = m_proj.project(b, m_level);
+
+    if (left == right) { return 1.0; }
+    if (!m_proj.contains(left) || !m_proj.contains(right)) { return -1.0; }
+
+    double levelLCA = m_proj.lcaLevel(left, right);
+    double distLeftLCA = m_proj.level(left) - levelLCA;
+    double distRightLCA = m_proj.level(right) - levelLCA;
+
+    return (1.0 + levelLCA)/(1.0 + levelLCA + distLeftLCA + distRightLCA);
+  }
+
+  common::Symbol match(const common::Symbol &a, const common::Symbol &b) const
+  {
+    common::Symbol left = m_proj.project(a, m_level);
+    common::Symbol right = m_proj.project(b, m_level);
+
+    if (left == right) { return left; }
+    if (!m_proj.contains(left) || !m_proj.contains(right)) { return common::Symbol(); }
+
+    return m_proj.project(left, m_proj.lcaLevel(left, right));
+  }
+
+ private:
+  const HierarchyProjection &m_proj;
+  boost::uint32_t m_level;
+};
+
+
+}
+
+
+#endif
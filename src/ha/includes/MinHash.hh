@@ -0,0 +1,155 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file MinHash.hh
+ * Declaration and implementation of the MinHash sketches approximating the similarity of sequences.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __MINHASH_HH__
+#define __MINHASH_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
+
+#include "HierarchyProjection.hh"
+#include "Types.hh"
+
+
+namespace ha
+{
+
+
+/** @class MinHash
+ *
+ * This class sketches sequences by the smallest hashes of their
+ * k-mers at every level of the hierarchy. A sequence is projected onto
+ * the ancestors of its symbols at the levels 1 to the depth of the
+ * hierarchy, and every k-mer of the projection at level L enters the
+ * set of the sequence L times, so that k-mers matching on deeper, more
+ * specific ancestors weigh more than those matching only near the
+ * root. The fraction of shared hashes among the smallest hashes of two
+ * sketches estimates the weighted Jaccard similarity of their sets in
+ * time linear in the size of the sketches, with a standard error of
+ * about sqrt(J (1 - J) / size). The symbols are hashed by their names,
+ * so that the sketches do not depend on the run.
+ */
+class MinHash
+{
+ public:
+  typedef std::vector<boost::uint64_t> sketch_t;
+
+  MinHash(const HierarchyProjection &p_proj, boost::uint32_t p_k, boost::uint32_t p_size)
+      : m_proj(p_proj), m_k(std::max<boost::uint32_t>(p_k, 1)), m_size(p_size)
+  {}
+
+  ~MinHash() {}
+
+  /** @fn void sketch(const common::StringVec &p_seq, sketch_t &p_sketch) const
+   * Keep the smallest distinct hashes of the weighted k-mers of a
+   * sequence in ascending order. Sequences shorter than k are a single
+   * k-mer.
+   */
+  void sketch(const common::StringVec &p_seq, sketch_t &p_sketch) const
+  {
+    common::StringVec projected;
+    std::hash<std::string> hasher;
+
+    p_sketch.clear();
+    for (boost::uint32_t level = 1; level <= std::max<boost::uint32_t>(m_proj.depth(), 1); ++level) {
+      m_proj.project(p_seq, level, projected);
+
+      std::size_t k = std::min<std::size_t>(m_k, projected.size());
+      for (std::size_t i = 0; k > 0 && i + k <= projected.size(); ++i) {
+        std::size_t kmer = level;
+        for (std::size_t j = i; j < i + k; ++j) {
+          boost::hash_combine(kmer, hasher(projected[j].get()));
+        }
+
+        // the copies of a k-mer are distinct elements of the set
+        for (boost::uint32_t copy = 0; copy < level; ++copy) {
+          p_sketch.push_back(mix(static_cast<boost::uint64_t>(kmer) + copy * UINT64_C(0x9e3779b97f4a7c15)));
+        }
+      }
+    }
+
+    std::sort(p_sketch.begin(), p_sketch.end());
+    p_sketch.erase(std::unique(p_sketch.begin(), p_sketch.end()), p_sketch.end());
+    if (p_sketch.size() > m_size) {
+      p_sketch.resize(m_size);
+    }
+    sketch_t(p_sketch).swap(p_sketch);
+  }
+
+  /** @fn double similarity(const sketch_t &p_a, const sketch_t &p_b) const
+   * @return the estimate of the weighted Jaccard similarity of two sketched sequences
+   */
+  double similarity(const sketch_t &p_a, const sketch_t &p_b) const
+  {
+    // the smallest hashes of the union are shared, if they are in both sketches
+    std::size_t i = 0, j = 0, n = 0, shared = 0;
+    while (n < m_size && i < p_a.size() && j < p_b.size()) {
+      if (p_a[i] == p_b[j]) {
+        ++shared;
+        ++i;
+        ++j;
+      } else if (p_a[i] < p_b[j]) {
+        ++i;
+      } else {
+        ++j;
+      }
+      ++n;
+    }
+    n += std::min<std::size_t>(m_size - n, (p_a.size() - i) + (p_b.size() - j));
+
+    return (n == 0) ? 0.0 : static_cast<double>(shared) / n;
+  }
+
+ private:
+  /** @fn static boost::uint64_t mix(boost::uint64_t p_x)
+   * the finaliser of splitmix64, spreading the k-mer hashes uniformly.
+   */
+  static boost::uint64_t mix(boost::uint64_t p_x)
+  {
+    p_x = (p_x ^ (p_x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    p_x = (p_x ^ (p_x >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return p_x ^ (p_x >> 31);
+  }
+
+  const HierarchyProjection &m_proj;
+  boost::uint32_t m_k;
+  boost::uint32_t m_size;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,111 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Normaliser.hh
+ * Declaration and implementation of the normalisations of alignment scores.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __NORMALISER_HH__
+#define __NORMALISER_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace ha
+{
+
+
+/**
+ * The normalisers are policies selected at compile time by the
+ * workers. Each provides a static normalise function of the raw score,
+ * the lengths of both sequences and their self-alignment scores. The
+ * self-alignment scores are only computed if a normaliser sets
+ * SELF_SCORES.
+ */
+
+
+/** @struct SquaredMinNormaliser
+ * score^2 / min(|a|, |b|)^2
+ */
+struct SquaredMinNormaliser
+{
+  static const bool SELF_SCORES = false;
+
+  static double normalise(double p_score, double p_len_a, double p_len_b, double, double)
+  {
+    double minSize = std::min(p_len_a, p_len_b);
+    return (p_score * p_score) / (minSize * minSize);
+  }
+};
+
+
+/** @struct MaxLengthNormaliser
+ * score / max(|a|, |b|)
+ */
+struct MaxLengthNormaliser
+{
+  static const bool SELF_SCORES = false;
+
+  static double normalise(double p_score, double p_len_a, double p_len_b, double, double)
+  {
+    return p_score / std::max(p_len_a, p_len_b);
+  }
+};
+
+
+/** @struct SelfScoreNormaliser
+ * score / sqrt(score(a, a) * score(b, b)), 0 for non-positive self-alignment scores
+ */
+struct SelfScoreNormaliser
+{
+  static const bool SELF_SCORES = true;
+
+  static double normalise(double p_score, double, double, double p_self_a, double p_self_b)
+  {
+    double selfScores = p_self_a * p_self_b;
+    return (selfScores > 0.0) ? p_score / std::sqrt(selfScores) : 0.0;
+  }
+};
+
+
+/** @struct RawNormaliser
+ * score
+ */
+struct RawNormaliser
+{
+  static const bool SELF_SCORES = false;
+
+  static double normalise(double p_score, double, double, double, double)
+  {
+    return p_score;
+  }
+};
+
+
+}
+
+
+#endif
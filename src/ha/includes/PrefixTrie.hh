@@ -0,0 +1,169 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file PrefixTrie.hh
+ * Declaration and implementation of the trie of the common prefixes of the queries.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __PREFIXTRIE_HH__
+#define __PREFIXTRIE_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "Types.hh"
+
+
+namespace ha
+{
+
+
+/** @class PrefixTrie
+ *
+ * This class keeps the trie of a set of sequences in pre-order. Every
+ * node but the root appends one symbol to the prefix of its parent,
+ * which is the last node before it one level closer to the root. A row
+ * of a dynamic programming matrix only depends on the prefix of the
+ * first sequence up to the row, so walking the nodes in order with one
+ * row per depth computes the rows of the common prefixes once for all
+ * sequences sharing them. The symbols of the nodes are indices into the
+ * alphabet of the sequences.
+ */
+class PrefixTrie
+{
+ public:
+  PrefixTrie(const common::Sequences &p_seqs)
+      : m_length(0), m_depth(0)
+  {
+    // the children of every node by the column of their symbol
+    std::vector<std::map<boost::uint32_t, boost::uint32_t> > children(1);
+    std::vector<boost::uint32_t> symbols(1, 0);
+    std::vector<std::vector<boost::uint32_t> > ends(1);
+    std::unordered_map<const std::string*, boost::uint32_t> columns;
+
+    for (boost::uint32_t u = 0; u < p_seqs.size(); ++u) {
+      boost::uint32_t node = 0;
+      for (boost::uint32_t k = 0; k < p_seqs[u].size(); ++k) {
+        std::pair<std::unordered_map<const std::string*, boost::uint32_t>::iterator, bool> col =
+            columns.insert(std::make_pair(&p_seqs[u][k].get(), m_alphabet.size()));
+        if (col.second) {
+          m_alphabet.push_back(p_seqs[u][k]);
+        }
+
+        std::pair<std::map<boost::uint32_t, boost::uint32_t>::iterator, bool> child =
+            children[node].insert(std::make_pair(col.first->second, children.size()));
+        if (child.second) {
+          children.push_back(std::map<boost::uint32_t, boost::uint32_t>());
+          symbols.push_back(col.first->second);
+          ends.push_back(std::vector<boost::uint32_t>());
+        }
+        node = child.first->second;
+      }
+      ends[node].push_back(u);
+      m_length += p_seqs[u].size();
+    }
+
+    // flatten the trie in pre-order
+    std::vector<std::pair<boost::uint32_t, boost::uint32_t> > stack(1, std::make_pair(0, 0));
+    while (!stack.empty()) {
+      boost::uint32_t node = stack.back().first, depth = stack.back().second;
+      stack.pop_back();
+
+      m_symbols.push_back(symbols[node]);
+      m_depths.push_back(depth);
+      m_ends.push_back(ends[node]);
+      m_depth = std::max(m_depth, depth);
+
+      for (std::map<boost::uint32_t, boost::uint32_t>::reverse_iterator it = children[node].rbegin();
+           it != children[node].rend(); ++it) {
+        stack.push_back(std::make_pair(it->second, depth + 1));
+      }
+    }
+  }
+
+  ~PrefixTrie() {}
+
+  /** @return the number of nodes, including the root of the empty prefix */
+  boost::uint32_t size() const
+  {
+    return m_symbols.size();
+  }
+
+  /** @return the column of the last symbol of the prefix of a node */
+  boost::uint32_t symbol(boost::uint32_t p_node) const
+  {
+    return m_symbols[p_node];
+  }
+
+  /** @return the length of the prefix of a node */
+  boost::uint32_t depth(boost::uint32_t p_node) const
+  {
+    return m_depths[p_node];
+  }
+
+  /** @return the length of the longest sequence */
+  boost::uint32_t maxDepth() const
+  {
+    return m_depth;
+  }
+
+  /** @return the sequences equal to the prefix of a node */
+  const std::vector<boost::uint32_t> & ends(boost::uint32_t p_node) const
+  {
+    return m_ends[p_node];
+  }
+
+  /** @return the symbols of the sequences */
+  const common::StringVec & alphabet() const
+  {
+    return m_alphabet;
+  }
+
+  /** @return the total length of the sequences, i.e., the rows without sharing */
+  boost::uint64_t length() const
+  {
+    return m_length;
+  }
+
+ private:
+  common::StringVec m_alphabet;
+  std::vector<boost::uint32_t> m_symbols;
+  std::vector<boost::uint32_t> m_depths;
+  std::vector<std::vector<boost::uint32_t> > m_ends;
+  boost::uint64_t m_length;
+  boost::uint32_t m_depth;
+};
+
+
+}
+
+
+#endif
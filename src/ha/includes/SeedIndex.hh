@@ -0,0 +1,167 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file SeedIndex.hh
+ * Declaration and implementation of the k-mer seed index used to filter candidate pairs.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __SEEDINDEX_HH__
+#define __SEEDINDEX_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
+
+#include "HierarchyProjection.hh"
+#include "Types.hh"
+
+
+namespace ha
+{
+
+
+/** @class SeedIndex
+ *
+ * This class keeps an inverted index from k-mers of projected symbols
+ * to the target sequences containing them. The symbols are projected
+ * onto their ancestors at a configurable level of the hierarchy
+ * before the k-mers are extracted, so that seeds match on related
+ * rather than identical categories. A query only needs to be aligned
+ * against the targets sharing a minimum number of distinct seeds with
+ * it. Targets shorter than k cannot be seeded and are always
+ * candidates.
+ */
+class SeedIndex
+{
+ public:
+  SeedIndex(const HierarchyProjection &p_proj, const common::Sequences &p_targets,
+            boost::uint32_t p_k, boost::uint32_t p_level, boost::uint32_t p_min)
+      : m_proj(p_proj), m_k(p_k), m_level(p_level), m_min(p_min),
+        m_counts(p_targets.size(), 0)
+  {
+    std::vector<std::size_t> kmers;
+
+    for (boost::uint32_t t = 0; t < p_targets.size(); ++t) {
+      if (p_targets[t].size() < m_k) {
+        m_short.push_back(t);
+        continue;
+      }
+
+      seeds(p_targets[t], kmers);
+      for (std::vector<std::size_t>::iterator it = kmers.begin(); it != kmers.end(); ++it) {
+        m_postings[*it].push_back(t);
+      }
+    }
+  }
+
+  ~SeedIndex() {}
+
+  /** @fn void candidates(const common::StringVec &p_query, std::vector<boost::uint32_t> &p_candidates)
+   * Collect the targets sharing at least the minimum number of distinct
+   * seeds with the query in ascending order.
+   *
+   * @param const common::StringVec & the query sequence
+   * @param std::vector<boost::uint32_t> & the candidate targets
+   */
+  void candidates(const common::StringVec &p_query, std::vector<boost::uint32_t> &p_candidates)
+  {
+    p_candidates.clear();
+
+    if (p_query.size() < m_k) {
+      for (boost::uint32_t t = 0; t < m_counts.size(); ++t) {
+        p_candidates.push_back(t);
+      }
+      return;
+    }
+
+    std::vector<std::size_t> kmers;
+    seeds(p_query, kmers);
+
+    std::vector<boost::uint32_t> touched;
+    for (std::vector<std::size_t>::iterator it = kmers.begin(); it != kmers.end(); ++it) {
+      Postings::const_iterator post = m_postings.find(*it);
+      if (post == m_postings.end()) {
+        continue;
+      }
+      for (std::vector<boost::uint32_t>::const_iterator t = post->second.begin(); t != post->second.end(); ++t) {
+        if (m_counts[*t]++ == 0) {
+          touched.push_back(*t);
+        }
+      }
+    }
+
+    for (std::vector<boost::uint32_t>::iterator t = touched.begin(); t != touched.end(); ++t) {
+      if (m_counts[*t] >= m_min) {
+        p_candidates.push_back(*t);
+      }
+      m_counts[*t] = 0;
+    }
+
+    p_candidates.insert(p_candidates.end(), m_short.begin(), m_short.end());
+    std::sort(p_candidates.begin(), p_candidates.end());
+  }
+
+ private:
+  typedef std::unordered_map<std::size_t, std::vector<boost::uint32_t> > Postings;
+
+  /** @fn void seeds(const common::StringVec &p_seq, std::vector<std::size_t> &p_kmers) const
+   * Extract the distinct hashed k-mers of the projected sequence.
+   */
+  void seeds(const common::StringVec &p_seq, std::vector<std::size_t> &p_kmers) const
+  {
+    common::StringVec projected;
+    m_proj.project(p_seq, m_level, projected);
+
+    p_kmers.clear();
+    for (std::size_t i = 0; i + m_k <= projected.size(); ++i) {
+      std::size_t seed = 0;
+      for (std::size_t j = i; j < i + m_k; ++j) {
+        boost::hash_combine(seed, &projected[j].get());
+      }
+      p_kmers.push_back(seed);
+    }
+
+    std::sort(p_kmers.begin(), p_kmers.end());
+    p_kmers.erase(std::unique(p_kmers.begin(), p_kmers.end()), p_kmers.end());
+  }
+
+  const HierarchyProjection &m_proj;
+  boost::uint32_t m_k;
+  boost::uint32_t m_level;
+  boost::uint32_t m_min;
+  Postings m_postings;
+  std::vector<boost::uint32_t> m_short;
+  std::vector<boost::uint32_t> m_counts;
+};
+
+
+}
+
+
+#endif
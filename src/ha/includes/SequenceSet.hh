@@ -0,0 +1,174 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file SequenceSet.hh
+ * Declaration and implementation of a hash-consed set of sequences.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __SEQUENCESET_HH__
+#define __SEQUENCESET_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
+
+#include "Types.hh"
+
+
+namespace ha
+{
+
+
+/** @struct SequenceHash
+ * Hashes a sequence of flyweight symbols. Equal symbols share the same
+ * flyweight value, so the address of the value identifies the symbol.
+ */
+struct SequenceHash
+{
+  std::size_t operator()(const common::StringVec &p_seq) const
+  {
+    std::size_t seed = p_seq.size();
+    for (common::StringVec::const_iterator it = p_seq.begin(); it != p_seq.end(); ++it) {
+      boost::hash_combine(seed, &it->get());
+    }
+    return seed;
+  }
+};
+
+
+/** @class SequenceSet
+ *
+ * This class keeps the sequences of an input set in hash-consed
+ * form. Identical sequences are stored once under a unique ID and
+ * every position of the input set refers to the unique ID of its
+ * sequence. The alignments only need to be computed for unique
+ * sequences and can be fanned out to the original positions.
+ */
+class SequenceSet
+{
+ public:
+  SequenceSet() {}
+  ~SequenceSet() {}
+
+  /** @fn bool load(const std::string &p_filename)
+   * Append the comma-separated sequences of a file to the set, one sequence per line.
+   *
+   * @param const std::string & the filename of the sequences
+   * @return true, if the file could be read. Otherwise the error is reported on std::cerr.
+   */
+  bool load(const std::string &p_filename);
+
+  /** @fn static void parse(const std::string &p_line, common::StringVec &p_seq)
+   * Split a line of comma-separated symbols into a sequence.
+   *
+   * @param const std::string & the line to split
+   * @param common::StringVec & the sequence of symbols
+   */
+  static void parse(const std::string &p_line, common::StringVec &p_seq);
+
+  /** @fn boost::uint32_t add(const common::StringVec &p_seq)
+   * Append a sequence to the set.
+   *
+   * @param const common::StringVec & the sequence to append
+   * @return the unique ID of the sequence
+   */
+  boost::uint32_t add(const common::StringVec &p_seq)
+  {
+    std::pair<IdMap::iterator, bool> ins = m_ids.insert(std::make_pair(p_seq, m_unique.size()));
+    if (ins.second) {
+      m_unique.push_back(p_seq);
+      m_multiplicity.push_back(0);
+    }
+
+    boost::uint32_t id = ins.first->second;
+    m_multiplicity[id]++;
+    m_positions.push_back(id);
+
+    return id;
+  }
+
+  /** @fn bool find(const common::StringVec &p_seq, boost::uint32_t &p_id) const
+   * @param const common::StringVec & the sequence to look up
+   * @param boost::uint32_t & the unique ID of the sequence, if it is part of the set
+   * @return true, if the sequence is part of the set
+   */
+  bool find(const common::StringVec &p_seq, boost::uint32_t &p_id) const
+  {
+    IdMap::const_iterator it = m_ids.find(p_seq);
+    if (it == m_ids.end()) {
+      return false;
+    }
+    p_id = it->second;
+    return true;
+  }
+
+  /** @return the number of sequences in the original input set */
+  std::size_t size() const
+  {
+    return m_positions.size();
+  }
+
+  /** @return the number of unique sequences */
+  std::size_t uniqueSize() const
+  {
+    return m_unique.size();
+  }
+
+  /** @return the unique ID of the sequence at the given input position */
+  boost::uint32_t id(std::size_t p_pos) const
+  {
+    return m_positions[p_pos];
+  }
+
+  /** @return the number of input positions sharing the given unique ID */
+  boost::uint32_t multiplicity(boost::uint32_t p_id) const
+  {
+    return m_multiplicity[p_id];
+  }
+
+  /** @return the unique sequences indexed by their unique ID */
+  common::Sequences & unique()
+  {
+    return m_unique;
+  }
+
+ private:
+  typedef std::unordered_map<common::StringVec, boost::uint32_t, SequenceHash> IdMap;
+
+  IdMap m_ids;
+  common::Sequences m_unique;
+  std::vector<boost::uint32_t> m_multiplicity;
+  std::vector<boost::uint32_t> m_positions;
+};
+
+
+}
+
+
+#endif
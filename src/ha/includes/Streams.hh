@@ -0,0 +1,214 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Streams.hh
+ * Declaration of the file streams reading and writing compressed files.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STREAMS_HH__
+#define __STREAMS_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+
+namespace ha
+{
+
+
+/** @enum codec_t
+ * the compression of a file.
+ */
+enum codec_t {
+  PLAIN = 0,
+  GZIP = 1,
+  ZSTD = 2
+};
+
+
+/** @class InputFile
+ *
+ * This class reads a file that is decompressed on the fly, if it starts
+ * with the magic bytes of gzip or zstd, and read as is otherwise. It is
+ * a drop-in replacement for std::ifstream.
+ */
+class InputFile : public boost::iostreams::filtering_istream
+{
+ public:
+  InputFile() {}
+  InputFile(const std::string &p_filename)
+  {
+    open(p_filename);
+  }
+  ~InputFile() {}
+
+  /** @fn bool open(const std::string &p_filename)
+   * @return false, if the file could not be opened
+   */
+  bool open(const std::string &p_filename);
+
+  bool is_open() const
+  {
+    return is_complete();
+  }
+
+  void close()
+  {
+    reset();
+  }
+};
+
+
+/** @class BlockBuffer
+ *
+ * This class buffers the output in large blocks. The blocks are
+ * compressed independently by a pool of threads into consecutive gzip
+ * members or zstd frames, which the decompressors read as a single
+ * stream, and written to the file in order. Flushing the stream does
+ * not cut a block short, the last block is written on close.
+ */
+class BlockBuffer : public std::streambuf, boost::noncopyable
+{
+ public:
+  /** bytes of a block */
+  static const std::size_t BLOCK_SIZE = 1 << 22;
+
+  BlockBuffer() : m_codec(PLAIN), m_closing(false), m_failed(false) {}
+  ~BlockBuffer();
+
+  bool open(const std::string &p_filename, codec_t p_codec, boost::uint32_t p_threads);
+  bool is_open() const
+  {
+    return m_file.is_open();
+  }
+
+  /** @fn bool close()
+   * Write the last block and wait for all blocks to be written.
+   *
+   * @return false, if a block could not be written
+   */
+  bool close();
+
+ protected:
+  int_type overflow(int_type p_c);
+  int sync();
+
+ private:
+  /** @struct block_t
+   * a block of the output, compressed by one of the threads.
+   */
+  struct block_t {
+    std::vector<char> data;
+    std::vector<char> compressed;
+    bool taken;
+    bool done;
+
+    block_t() : taken(false), done(false) {}
+  };
+
+  void submit();
+  void run();
+  void compress(const std::vector<char> &p_in, std::vector<char> &p_out) const;
+  void drain();
+
+  std::ofstream m_file;
+  codec_t m_codec;
+  std::vector<char> m_block;
+  std::deque<std::shared_ptr<block_t> > m_queue;
+  std::vector<std::thread> m_threads;
+  std::mutex m_mutex;
+  std::condition_variable m_ready;
+  std::condition_variable m_space;
+  bool m_closing;
+  bool m_failed;
+};
+
+
+/** @class OutputFile
+ *
+ * This class writes a file through a block buffer, optionally
+ * compressed by a pool of threads. It is a drop-in replacement for
+ * std::ofstream.
+ */
+class OutputFile : public std::ostream
+{
+ public:
+  OutputFile() : std::ostream(&m_buffer) {}
+  ~OutputFile()
+  {
+    close();
+  }
+
+  /** @fn bool open(const std::string &p_filename, codec_t p_codec, boost::uint32_t p_threads)
+   * @param const std::string & the name of the file, without the extension of the codec
+   * @param codec_t the compression of the file
+   * @param boost::uint32_t the number of threads compressing the blocks
+   * @return false, if the file could not be opened
+   */
+  bool open(const std::string &p_filename, codec_t p_codec = PLAIN, boost::uint32_t p_threads = 1);
+
+  bool is_open() const
+  {
+    return m_buffer.is_open();
+  }
+
+  void close()
+  {
+    if (m_buffer.is_open() && !m_buffer.close()) {
+      setstate(std::ios::badbit);
+    }
+  }
+
+  /** @return the extension of the files written with a codec */
+  static std::string extension(codec_t p_codec);
+
+  /** @fn static bool codec(const std::string &p_name, codec_t &p_codec)
+   * @param const std::string & the name of the codec: empty, gzip or zstd
+   * @return false, if the codec is not known
+   */
+  static bool codec(const std::string &p_name, codec_t &p_codec);
+
+ private:
+  BlockBuffer m_buffer;
+};
+
+
+}
+
+
+#endif
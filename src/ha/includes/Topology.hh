@@ -0,0 +1,106 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Topology.hh
+ * Declaration of the NUMA topology used to place the worker threads.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __TOPOLOGY_HH__
+#define __TOPOLOGY_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+
+namespace ha
+{
+
+
+/** @class Topology
+ *
+ * This class keeps the CPUs of the NUMA nodes of the machine that the
+ * process may run on. Worker threads are distributed round-robin over
+ * the nodes, i.e., worker t runs on node t modulo the number of nodes,
+ * so that any number of workers is spread evenly across the sockets.
+ * Without any topology loaded, all workers share a single node and are
+ * not pinned.
+ */
+class Topology
+{
+ public:
+  Topology() {}
+  ~Topology() {}
+
+  /** @fn bool load(const std::string &p_root)
+   * Read the CPUs of the NUMA nodes from sysfs and restrict them to the
+   * CPUs the process may run on.
+   *
+   * @param const std::string & the sysfs directory of the nodes
+   * @return false, if the topology is not available
+   */
+  bool load(const std::string &p_root = "/sys/devices/system/node");
+
+  /** @return the number of NUMA nodes, at least 1 */
+  boost::uint32_t nodes() const
+  {
+    return m_cpus.empty() ? 1 : m_cpus.size();
+  }
+
+  /** @return the NUMA node of the given worker thread */
+  boost::uint32_t node(boost::uint32_t p_thread) const
+  {
+    return p_thread % nodes();
+  }
+
+  /** @fn bool pin(boost::uint32_t p_thread) const
+   * Pin the calling thread to the CPU of the given worker thread. The
+   * CPU of a thread is remembered, so that repeated calls are cheap.
+   *
+   * @return false, if the thread could not be pinned
+   */
+  bool pin(boost::uint32_t p_thread) const;
+
+  /** @fn bool restore() const
+   * Allow the calling thread all CPUs of the process again, if it has
+   * been pinned. The threads it starts later inherit its CPUs.
+   *
+   * @return false, if the CPUs of the thread could not be restored
+   */
+  bool restore() const;
+
+ private:
+  static bool parse(const std::string &p_list, std::vector<boost::uint32_t> &p_cpus);
+
+  std::vector<std::vector<boost::uint32_t> > m_cpus;
+  std::vector<boost::uint32_t> m_process;    /* the CPUs the process may run on */
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,231 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file TreePathSimilarityMeasure
+ * Declaration of the tree-based path similarity scoring scheme for alignments.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __TREEPATHSIMILARITYMEASURE_HH__
+#define __TREEPATHSIMILARITYMEASURE_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "AbstractDistanceMeasure.hh"
+#include "Buffer.hh"
+#include "Types.hh"
+
+
+namespace ha
+{
+
+
+/** @class TreePathSimilarityMeasure
+ *
+ * This class implements the tree path similarity of two symbols,
+ * d(a, b) = (1 + l(lca)) / (1 + l(lca) + l(a) - l(lca) + l(b) - l(lca)).
+ * The scheme is frozen at construction: every symbol of the Euler
+ * circuit gets a dense ID, and the similarity and the LCA ID of every
+ * pair of the offline LCA table are precomputed. The lookups are const,
+ * never allocate and can be shared by all threads. Symbols outside the
+ * Euler circuit and pairs without an LCA have a similarity of -1 and
+ * match the empty symbol. The pairs are kept in a single open
+ * addressing table, which may be backed by huge pages.
+ */
+class TreePathSimilarityMeasure : public alignment::AbstractDistanceMeasure
+{
+ public:
+  /** ID of the symbols outside the Euler circuit */
+  static const boost::uint32_t UNKNOWN = std::numeric_limits<boost::uint32_t>::max();
+
+  TreePathSimilarityMeasure(double p_delta, const common::DoubleVec &p_levels, const common::StringIntMap &p_pos,
+                            const common::StrStrMap &p_lcas)
+      : alignment::AbstractDistanceMeasure(p_delta), m_unknown()
+  {
+    for (common::StringIntMap::const_iterator it = p_pos.begin(); it != p_pos.end(); ++it) {
+      m_ids[&it->first.get()] = m_symbols.size();
+      m_symbols.push_back(it->first);
+      m_positions.push_back(it->second);
+    }
+
+    std::vector<pair_t> pairs;
+    for (common::StrStrMap::const_iterator it = p_lcas.begin(); it != p_lcas.end(); ++it) {
+      boost::uint32_t left = id(std::get<0>(it->first));
+      boost::uint32_t right = id(std::get<1>(it->first));
+      boost::uint32_t lca = id(it->second);
+
+      // only the keys in the order of the Euler circuit are ever looked up
+      if (left == UNKNOWN || right == UNKNOWN || m_positions[left] >= m_positions[right]) {
+        continue;
+      }
+      if (lca == UNKNOWN) {
+        std::cerr << "The LCA " << it->second << " is not part of the Euler circuit, ignoring it!" << std::endl;
+        continue;
+      }
+
+      double levelLCA = p_levels[m_positions[lca]];
+      double distLeftLCA = p_levels[m_positions[left]] - levelLCA;
+      double distRightLCA = p_levels[m_positions[right]] - levelLCA;
+
+      pair_t pair;
+      pair.key = key(left, right);
+      pair.score = (1.0 + levelLCA)/(1.0 + levelLCA + distLeftLCA + distRightLCA);
+      pair.lca = lca;
+      pairs.push_back(pair);
+    }
+
+    // the table is at most half full, so that every probe ends at an empty slot
+    m_bits = 1;
+    while ((static_cast<boost::uint64_t>(1) << m_bits) < 2 * pairs.size()) {
+      ++m_bits;
+    }
+    m_mask = (static_cast<boost::uint64_t>(1) << m_bits) - 1;
+    m_pairs.allocate(m_mask + 1);
+    for (boost::uint64_t s = 0; s <= m_mask; ++s) {
+      m_pairs[s].key = EMPTY;
+    }
+
+    for (std::vector<pair_t>::iterator it = pairs.begin(); it != pairs.end(); ++it) {
+      boost::uint64_t s = slot(it->key);
+      while (m_pairs[s].key != EMPTY && m_pairs[s].key != it->key) {
+        s = (s + 1) & m_mask;
+      }
+      m_pairs[s] = *it;
+    }
+  }
+
+  ~TreePathSimilarityMeasure() {}
+
+  /** @return the dense ID of a symbol, or UNKNOWN if it is not part of the Euler circuit */
+  boost::uint32_t id(const common::Symbol &a) const
+  {
+    std::unordered_map<const std::string*, boost::uint32_t>::const_iterator it = m_ids.find(&a.get());
+    return (it == m_ids.end()) ? UNKNOWN : it->second;
+  }
+
+  /** @return the number of symbols with a dense ID */
+  boost::uint32_t size() const
+  {
+    return m_symbols.size();
+  }
+
+  /** @return the symbol of a dense ID */
+  const common::Symbol & symbol(boost::uint32_t p_id) const
+  {
+    return (p_id == UNKNOWN) ? m_unknown : m_symbols[p_id];
+  }
+
+  /** @return the similarity of two symbols given by their dense IDs */
+  double d(boost::uint32_t a, boost::uint32_t b) const
+  {
+    if (a == b) { return (a == UNKNOWN) ? -1.0 : 1.0; }
+
+    const pair_t *pair = find(a, b);
+    return pair ? pair->score : -1.0;
+  }
+
+  /** @return the dense ID of the LCA of two symbols given by their dense IDs, or UNKNOWN */
+  boost::uint32_t lca(boost::uint32_t a, boost::uint32_t b) const
+  {
+    if (a == b) { return a; }
+
+    const pair_t *pair = find(a, b);
+    return pair ? pair->lca : UNKNOWN;
+  }
+
+  double d(const common::Symbol &a, const common::Symbol &b) const
+  {
+    if (a == b) { return 1.0; }
+
+    return d(id(a), id(b));
+  }
+
+  common::Symbol match(const common::Symbol &a, const common::Symbol &b) const
+  {
+    if (a == b) { return a; }
+
+    const common::Symbol &ancestor = symbol(lca(id(a), id(b)));
+
+#ifndef NDEBUG
+    std::cout << "match: " << a << ", " << b << ", " << ancestor << std::endl;
+#endif
+
+    return ancestor;
+  }
+
+ private:
+  /** @struct pair_t
+   * the precomputed similarity and LCA of a pair of symbols.
+   */
+  struct pair_t {
+    boost::uint64_t key;
+    double score;
+    boost::uint32_t lca;
+  };
+
+  /** key of the empty slots, the keys of two distinct known symbols never collide with it */
+  static const boost::uint64_t EMPTY = std::numeric_limits<boost::uint64_t>::max();
+
+  static boost::uint64_t key(boost::uint32_t left, boost::uint32_t right)
+  {
+    return (static_cast<boost::uint64_t>(left) << 32) | right;
+  }
+
+  /** @return the first slot probed for a key (Fibonacci hashing) */
+  boost::uint64_t slot(boost::uint64_t k) const
+  {
+    return (k * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - m_bits);
+  }
+
+  /** @return the pair of two distinct symbols, or NULL if they have no LCA */
+  const pair_t * find(boost::uint32_t a, boost::uint32_t b) const
+  {
+    if (a == UNKNOWN || b == UNKNOWN) { return NULL; }
+
+    boost::uint64_t k = (m_positions[a] < m_positions[b]) ? key(a, b) : key(b, a);
+    for (boost::uint64_t s = slot(k); ; s = (s + 1) & m_mask) {
+      if (m_pairs[s].key == k) { return &m_pairs[s]; }
+      if (m_pairs[s].key == EMPTY) { return NULL; }
+    }
+  }
+
+  const common::Symbol m_unknown;
+  std::unordered_map<const std::string*, boost::uint32_t> m_ids;
+  std::vector<common::Symbol> m_symbols;
+  std::vector<boost::uint32_t> m_positions;
+  alignment::Buffer<pair_t> m_pairs;
+  boost::uint64_t m_mask;
+  boost::uint32_t m_bits;
+};
+
+
+}
+
+
+#endif
@@ -27,14 +27,21 @@
 # define __STDC_CONSTANT_MACROS
 #endif /* __STDC_CONSTANT_MACROS */
 
+#include <algorithm>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
 #include <boost/filesystem.hpp>
 namespace fs = boost::filesystem;
 
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/parsers.hpp>
+#include <boost/program_options/positional_options.hpp>
 #include <boost/program_options/variables_map.hpp>
 namespace po = boost::program_options;
 
@@ -51,6 +58,20 @@ CL::CL()
       (VERS.c_str(), "show the version")
       ;
 
+  po::options_description opt_serve("Server Configuration");
+  opt_serve.add_options()
+      (MODE.c_str(), po::value <std::string>()->default_value("align"), "Mode: align - align set 1 against set 2, serve - answer queries against set 2.")
+      (SOCKET.c_str(), po::value <std::string>()->default_value(""), "Unix domain socket of the server (stdin/stdout if empty).")
+      (TOP_K.c_str(), po::value <boost::uint32_t>()->default_value(10), "Number of best matches returned per query by the server.")
+      ;
+
+  po::options_description opt_update("Incremental Update Configuration");
+  opt_update.add_options()
+      (PREVIOUS.c_str(), po::value <std::string>()->default_value(""), "Results directory of the run to update.")
+      (DELTA.c_str(), po::value <std::string>()->default_value(""), "Filename of the sequences added to (+) and removed from (-) set 2.")
+      (EXTEND.c_str(), po::value <bool>()->default_value(0), "Extend the frontiers of --previous, if any, to the grown sequences and keep them for the next run (requires --scores 1 and --alg 1 or 2).")
+      ;
+
   po::options_description opt_io("I/O Configuration");
   opt_io.add_options()
       (RESULTS_DIR.c_str(), po::value <std::string>()->default_value("./results"), "results directory.")
@@ -59,26 +80,90 @@ CL::CL()
       (LCA.c_str(), po::value <std::string>()->default_value(""), "Filename with the LCAs computed offline.")
       (SET_1.c_str(), po::value <std::string>()->default_value(""), "Filename of the source set.")
       (SET_2.c_str(), po::value <std::string>()->default_value(""), "Filename of the target set.")
+      (ALIGNMENTS.c_str(), po::value <std::string>()->default_value(""), "Format of the alignment output: tsv, binary (requires --scores 0).")
+      (COMPRESS.c_str(), po::value <std::string>()->default_value(""), "Compression of the scores and alignments: gzip, zstd.")
+      (COMPRESS_THREADS.c_str(), po::value <boost::uint32_t>()->default_value(2), "Number of threads compressing the output blocks.")
+      (JOBS.c_str(), po::value <std::string>()->default_value(""), "Filename of the manifest of jobs, one line of options per comparison sharing the hierarchy and the workers.")
+      (AGGREGATE.c_str(), po::value <boost::int32_t>()->default_value(0), "Aggregates of the scores of every sequence of set 1: 0 - none, 1 - next to the score matrix, 2 - instead of the score matrix.")
+      (AGG_BINS.c_str(), po::value <boost::uint32_t>()->default_value(10), "Number of bins of the histograms of the aggregates.")
+      (AGG_MIN.c_str(), po::value <double>()->default_value(0.0), "Lower bound of the first bin of the histograms.")
+      (AGG_MAX.c_str(), po::value <double>()->default_value(1.0), "Upper bound of the last bin of the histograms.")
+      (AGG_THRESHOLDS.c_str(), po::value <std::string>()->default_value(""), "Comma-separated thresholds, the aggregates count the scores at or above each.")
       ;
 
   po::options_description opt_ha("Algorithm Configuration");
   opt_ha.add_options()
-      (ALG.c_str(), po::value <boost::int32_t>()->default_value(1), "Algorithm: 1 - local alignment, 2 - global alignment.")
+      (ALG.c_str(), po::value <boost::int32_t>()->default_value(1), "Algorithm: 1 - local alignment, 2 - global alignment, 3 - local and global scores, 4 - approximate local scores (3 and 4 require --scores 1).")
       (SCORES.c_str(), po::value <bool>()->default_value(0), "Compute just alignment scores, no backtracking.")
       (GAP_PENALTY.c_str(), po::value <double>()->default_value(1.33), "Gap penalty for the alignments.")
+      (NORM.c_str(), po::value <boost::int32_t>()->default_value(1), "Normalisation: 1 - score^2/min(|a|,|b|)^2, 2 - score/max(|a|,|b|), 3 - score/sqrt(self(a)*self(b)), 4 - raw score.")
+      (RLE.c_str(), po::value <bool>()->default_value(0), "Compute the scores on runs of identical symbols (requires --scores 1).")
+      (XDROP.c_str(), po::value <double>()->default_value(0.0), "Stop extending the local alignments at cells scoring more than X below the maximum (0 - exact).")
+      (SWEEP.c_str(), po::value <std::string>()->default_value(""), "Comma-separated gap penalties scored in one pass, one matrix each (requires --scores 1).")
+      (TRIE.c_str(), po::value <bool>()->default_value(0), "Share the rows of the matrices among the sequences of set 1 with common prefixes (requires --scores 1 and --alg 1 or 2).")
+      ;
+
+  po::options_description opt_seed("Seed Filter Configuration");
+  opt_seed.add_options()
+      (SEED_K.c_str(), po::value <boost::uint32_t>()->default_value(0), "Length of the k-mer seeds (0 - no seed filter).")
+      (SEED_LEVEL.c_str(), po::value <boost::uint32_t>()->default_value(1), "Level of the hierarchy the seed symbols are projected onto.")
+      (SEED_MIN.c_str(), po::value <boost::uint32_t>()->default_value(1), "Minimum number of distinct seeds shared by a candidate pair.")
+      ;
+
+  po::options_description opt_coarse("Multi-Resolution Configuration");
+  opt_coarse.add_options()
+      (COARSE_LEVEL.c_str(), po::value <boost::uint32_t>()->default_value(0), "Level of the hierarchy for the coarse alignments (0 - no coarse alignments).")
+      (COARSE_MIN.c_str(), po::value <double>()->default_value(0.5), "Minimum normalised coarse score for the full alignment of a pair.")
+      ;
+
+  po::options_description opt_sketch("Approximation Configuration");
+  opt_sketch.add_options()
+      (SKETCH_K.c_str(), po::value <boost::uint32_t>()->default_value(2), "Length of the k-mers of the sketches (--alg 4).")
+      (SKETCH_SIZE.c_str(), po::value <boost::uint32_t>()->default_value(128), "Number of hashes of a sketch (--alg 4).")
+      (SKETCH_SAMPLE.c_str(), po::value <boost::uint32_t>()->default_value(1000), "Number of pairs aligned to calibrate the approximate scores and estimate their error (0 - raw sketch similarities).")
+      ;
+
+  po::options_description opt_resources("Resource Configuration");
+  opt_resources.add_options()
+      (NUMA.c_str(), po::value <bool>()->default_value(0), "Pin the workers to the NUMA nodes, each reading its own copy of the scoring scheme and set 2.")
+      (HUGE_PAGES.c_str(), po::value <boost::int32_t>()->default_value(0), "Pages of the matrices and score table: 0 - small pages, 1 - transparent huge pages, 2 - explicit huge pages.")
+      (DP_CAP.c_str(), po::value <boost::uint32_t>()->default_value(0), "MiB of the matrices of a worker, larger pairs are scored in linear space without alignment (0 - no limit).")
+      (WAVEFRONT.c_str(), po::value <boost::uint32_t>()->default_value(64), "Million cells of a pair above which all workers score it together in tiles, if no alignment is kept (0 - never).")
+      (WAVEFRONT_TILE.c_str(), po::value <boost::uint32_t>()->default_value(256), "Rows and columns of the tiles of the pairs scored by all workers together.")
+      (MEM_LIMIT.c_str(), po::value <boost::uint32_t>()->default_value(0), "MiB the whole run has to fit into, the workers, the kernel, the tiles and the rows kept are planned for it (0 - no limit).")
       ;
 
   m_opt_desc->add(opt_general);
+  m_opt_desc->add(opt_serve);
+  m_opt_desc->add(opt_update);
   m_opt_desc->add(opt_io);
   m_opt_desc->add(opt_ha);
+  m_opt_desc->add(opt_seed);
+  m_opt_desc->add(opt_coarse);
+  m_opt_desc->add(opt_sketch);
+  m_opt_desc->add(opt_resources);
 }
 
 
 int CL::parse(int argc, char *argv[], args_t &p_args)
+{
+  return parse(argc, argv, std::vector<std::string>(), p_args);
+}
+
+
+int CL::parse(int argc, char *argv[], const std::vector<std::string> &p_job, args_t &p_args)
 {
   po::variables_map vm;
 
-  po::store(po::parse_command_line(argc, argv, (*m_opt_desc.get())), vm);
+  // the mode can be given as the first positional argument, e.g. "ha serve ..."
+  po::positional_options_description pos;
+  pos.add(MODE.c_str(), 1);
+
+  // the values stored first are kept, so the options of a job override the command line
+  if (!p_job.empty()) {
+    po::store(po::command_line_parser(p_job).options(*m_opt_desc.get()).run(), vm);
+  }
+  po::store(po::command_line_parser(argc, argv).options(*m_opt_desc.get()).positional(pos).run(), vm);
   po::notify(vm);
 
   if (vm.count(HELP)) {
@@ -92,6 +177,44 @@ int CL::parse(int argc, char *argv[], args_t &p_args)
     return EXIT_FAILURE;
   }
 
+  if (vm.count(MODE.c_str())) {
+    p_args.mode = vm[MODE.c_str()].as <std::string>();
+    if (p_args.mode != "align" && p_args.mode != "serve") {
+      std::cerr << "The mode has to be one of align or serve!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(SOCKET.c_str())) {
+    p_args.socket = vm[SOCKET.c_str()].as <std::string>();
+  }
+
+  if (vm.count(TOP_K.c_str())) {
+    p_args.top_k = vm[TOP_K.c_str()].as <boost::uint32_t>();
+    if (p_args.top_k == 0) {
+      std::cerr << "The number of best matches has to be positive!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(PREVIOUS.c_str())) {
+    p_args.previous = vm[PREVIOUS.c_str()].as <std::string>();
+  }
+
+  if (vm.count(DELTA.c_str())) {
+    p_args.delta = vm[DELTA.c_str()].as <std::string>();
+    if (p_args.delta != "") {
+      if (!fs::exists(p_args.delta)) {
+        std::cerr << "The filename " << p_args.delta << " containing the delta of set 2 does not exist!" << std::endl;
+        return EXIT_FAILURE;
+      }
+      if (!fs::is_directory(p_args.previous)) {
+        std::cerr << "The update of set 2 requires the results directory of the previous run, use --previous!" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
   if (vm.count(RESULTS_DIR.c_str())) {
     p_args.results_dir = vm[RESULTS_DIR.c_str()].as <std::string>();
   }
@@ -120,9 +243,11 @@ int CL::parse(int argc, char *argv[], args_t &p_args)
     }
   }
 
-  if (vm.count(SET_1.c_str())) {
+  // the server only needs the target set, the jobs of a manifest name their own sets
+  bool manifest = vm.count(JOBS.c_str()) && vm[JOBS.c_str()].as <std::string>() != "";
+  if (vm.count(SET_1.c_str()) && p_args.mode != "serve") {
     p_args.set_1 = vm[SET_1.c_str()].as <std::string>();
-    if (!fs::exists(p_args.set_1)) {
+    if (!(manifest && p_args.set_1 == "") && !fs::exists(p_args.set_1)) {
       std::cerr << "The filename " << p_args.set_1 << " containing the source set does not exist!" << std::endl;
       return EXIT_FAILURE;
     }
@@ -130,14 +255,52 @@ int CL::parse(int argc, char *argv[], args_t &p_args)
 
   if (vm.count(SET_2.c_str())) {
     p_args.set_2 = vm[SET_2.c_str()].as <std::string>();
-    if (!fs::exists(p_args.set_2)) {
+    if (!(manifest && p_args.set_2 == "") && !fs::exists(p_args.set_2)) {
       std::cerr << "The filename " << p_args.set_2 << " containing the target set does not exist!" << std::endl;
       return EXIT_FAILURE;
     }
   }
 
+  if (vm.count(ALIGNMENTS.c_str())) {
+    p_args.alignments = vm[ALIGNMENTS.c_str()].as <std::string>();
+    if (p_args.alignments != "" && p_args.alignments != "tsv" && p_args.alignments != "binary") {
+      std::cerr << "The format of the alignment output has to be one of tsv or binary!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (p_args.alignments != "" && vm[SCORES.c_str()].as <bool>()) {
+      std::cerr << "The alignment output requires the alignments, use --scores 0!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(COMPRESS.c_str())) {
+    p_args.compress = vm[COMPRESS.c_str()].as <std::string>();
+    if (p_args.compress != "" && p_args.compress != "gzip" && p_args.compress != "zstd") {
+      std::cerr << "The compression has to be one of gzip or zstd!" << std::endl;
+      return EXIT_FAILURE;
+    }
+#ifndef HAVE_BOOST_IOSTREAMS_ZSTD
+    if (p_args.compress == "zstd") {
+      std::cerr << "This build does not support zstd, Boost.Iostreams lacks the zstd filter!" << std::endl;
+      return EXIT_FAILURE;
+    }
+#endif /* HAVE_BOOST_IOSTREAMS_ZSTD */
+  }
+
+  if (vm.count(COMPRESS_THREADS.c_str())) {
+    p_args.compress_threads = vm[COMPRESS_THREADS.c_str()].as <boost::uint32_t>();
+    if (p_args.compress_threads < 1) {
+      std::cerr << "At least one thread has to compress the output!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
   if (vm.count(ALG.c_str())) {
     p_args.alg = vm[ALG.c_str()].as <boost::int32_t>();
+    if (p_args.alg < 1 || p_args.alg > 4) {
+      std::cerr << "The algorithm has to be one of 1, 2, 3 or 4!" << std::endl;
+      return EXIT_FAILURE;
+    }
   }
 
   if (vm.count(SCORES.c_str())) {
@@ -148,9 +311,260 @@ int CL::parse(int argc, char *argv[], args_t &p_args)
     p_args.gap_penalty = vm[GAP_PENALTY.c_str()].as <double>();
   }
 
-  std::cout << argv[0] << " " << PACKAGE_VERSION << std::endl;
-  std::cout << PACKAGE_NAME << std::endl;
-  std::cout << p_args << std::endl;
+  if (vm.count(NORM.c_str())) {
+    p_args.norm = vm[NORM.c_str()].as <boost::int32_t>();
+    if (p_args.norm < 1 || p_args.norm > 4) {
+      std::cerr << "The normalisation has to be one of 1, 2, 3 or 4!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(RLE.c_str())) {
+    p_args.rle = vm[RLE.c_str()].as <bool>();
+    if (p_args.rle && !p_args.scores) {
+      std::cerr << "The run-length encoded alignment only computes scores, use --scores 1!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(XDROP.c_str())) {
+    p_args.xdrop = vm[XDROP.c_str()].as <double>();
+    if (p_args.xdrop < 0.0) {
+      std::cerr << "The X-drop cannot be negative!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(SWEEP.c_str()) && vm[SWEEP.c_str()].as <std::string>() != "") {
+    std::vector<std::string> penalties;
+    boost::split(penalties, vm[SWEEP.c_str()].as <std::string>(), boost::is_any_of(","));
+    try {
+      for (std::vector<std::string>::iterator it = penalties.begin(); it != penalties.end(); ++it) {
+        p_args.sweep.push_back(boost::lexical_cast<double>(*it));
+      }
+    } catch (boost::bad_lexical_cast &) {
+      std::cerr << "The gap penalties of the sweep have to be comma-separated numbers!" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // every gap penalty names its own score matrix
+    std::vector<double> distinct(p_args.sweep);
+    std::sort(distinct.begin(), distinct.end());
+    if (std::unique(distinct.begin(), distinct.end()) != distinct.end()) {
+      std::cerr << "The gap penalties of the sweep have to be distinct!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!p_args.scores || p_args.rle || p_args.xdrop > 0.0) {
+      std::cerr << "The sweep only computes exact scores, use --scores 1 without --rle and --xdrop!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (p_args.mode != "align" || p_args.delta != "") {
+      std::cerr << "The sweep cannot serve queries or update previous results!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // the local and global scores are computed by the lanes of a sweep, the
+  // approximate scores are calibrated against the exact local alignments
+  if (p_args.alg == 3 || p_args.alg == 4) {
+    if (!p_args.scores || p_args.rle || p_args.xdrop > 0.0) {
+      std::cerr << "The algorithms 3 and 4 only compute scores, use --scores 1 without --rle and --xdrop!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (p_args.mode != "align" || p_args.delta != "") {
+      std::cerr << "The algorithms 3 and 4 cannot serve queries or update previous results!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (p_args.alg == 4 && !p_args.sweep.empty()) {
+    std::cerr << "The approximate scores do not depend on the gap penalty, remove --sweep!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count(SEED_K.c_str())) {
+    p_args.seed_k = vm[SEED_K.c_str()].as <boost::uint32_t>();
+  }
+
+  if (vm.count(SEED_LEVEL.c_str())) {
+    p_args.seed_level = vm[SEED_LEVEL.c_str()].as <boost::uint32_t>();
+  }
+
+  if (vm.count(SEED_MIN.c_str())) {
+    p_args.seed_min = vm[SEED_MIN.c_str()].as <boost::uint32_t>();
+    if (p_args.seed_min == 0) {
+      std::cerr << "The minimum number of shared seeds has to be positive!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(COARSE_LEVEL.c_str())) {
+    p_args.coarse_level = vm[COARSE_LEVEL.c_str()].as <boost::uint32_t>();
+  }
+
+  if (vm.count(COARSE_MIN.c_str())) {
+    p_args.coarse_min = vm[COARSE_MIN.c_str()].as <double>();
+  }
+
+  if (vm.count(SKETCH_K.c_str())) {
+    p_args.sketch_k = vm[SKETCH_K.c_str()].as <boost::uint32_t>();
+    if (p_args.sketch_k == 0) {
+      std::cerr << "The k-mers of the sketches cannot be empty!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(SKETCH_SIZE.c_str())) {
+    p_args.sketch_size = vm[SKETCH_SIZE.c_str()].as <boost::uint32_t>();
+    if (p_args.sketch_size == 0) {
+      std::cerr << "The sketches need at least one hash!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(SKETCH_SAMPLE.c_str())) {
+    p_args.sketch_sample = vm[SKETCH_SAMPLE.c_str()].as <boost::uint32_t>();
+  }
+
+  if (vm.count(NUMA.c_str())) {
+    p_args.numa = vm[NUMA.c_str()].as <bool>();
+  }
+
+  if (vm.count(HUGE_PAGES.c_str())) {
+    p_args.huge_pages = vm[HUGE_PAGES.c_str()].as <boost::int32_t>();
+    if (p_args.huge_pages < 0 || p_args.huge_pages > 2) {
+      std::cerr << "The huge pages have to be one of 0, 1 or 2!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(DP_CAP.c_str())) {
+    p_args.dp_cap = vm[DP_CAP.c_str()].as <boost::uint32_t>();
+  }
+
+  if (vm.count(WAVEFRONT.c_str())) {
+    p_args.wavefront = vm[WAVEFRONT.c_str()].as <boost::uint32_t>();
+  }
+
+  if (vm.count(WAVEFRONT_TILE.c_str())) {
+    p_args.wavefront_tile = vm[WAVEFRONT_TILE.c_str()].as <boost::uint32_t>();
+    if (p_args.wavefront_tile == 0) {
+      std::cerr << "The tiles of the wavefront have to be larger than 0!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // the trie keeps a row per symbol of the longest query of every target
+  // and computes the exact scores of all pairs
+  if (vm.count(TRIE.c_str())) {
+    p_args.trie = vm[TRIE.c_str()].as <bool>();
+    if (p_args.trie && (!p_args.scores || p_args.rle || p_args.xdrop > 0.0 || !p_args.sweep.empty())) {
+      std::cerr << "The prefix trie only computes exact scores, use --scores 1 without --rle, --xdrop and --sweep!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (p_args.trie && (p_args.alg > 2 || p_args.seed_k > 0 || p_args.coarse_level > 0 || p_args.dp_cap > 0)) {
+      std::cerr << "The prefix trie aligns all pairs in full, use --alg 1 or 2 without --seed_k, --coarse_level and --dp_cap!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // the frontiers keep the last row and column of the exact scores of all pairs
+  if (vm.count(EXTEND.c_str())) {
+    p_args.extend = vm[EXTEND.c_str()].as <bool>();
+    if (p_args.extend && (!p_args.scores || p_args.rle || p_args.xdrop > 0.0 || !p_args.sweep.empty() || p_args.trie)) {
+      std::cerr << "The frontiers only extend exact scores, use --scores 1 without --rle, --xdrop, --sweep and --trie!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (p_args.extend && (p_args.alg > 2 || p_args.seed_k > 0 || p_args.coarse_level > 0 || p_args.dp_cap > 0)) {
+      std::cerr << "The frontiers cover all pairs in full, use --alg 1 or 2 without --seed_k, --coarse_level and --dp_cap!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (p_args.extend && (p_args.mode != "align" || p_args.delta != "")) {
+      std::cerr << "The frontiers cannot be extended while serving queries or updating set 2!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (p_args.extend && p_args.previous != "" && !fs::is_directory(p_args.previous)) {
+      std::cerr << "The previous results directory " << p_args.previous << " does not exist!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(JOBS.c_str())) {
+    p_args.jobs = vm[JOBS.c_str()].as <std::string>();
+    if (p_args.jobs != "") {
+      if (!fs::exists(p_args.jobs)) {
+        std::cerr << "The filename " << p_args.jobs << " containing the jobs does not exist!" << std::endl;
+        return EXIT_FAILURE;
+      }
+      if (p_args.mode != "align") {
+        std::cerr << "The jobs can only be aligned, not served!" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // the plan covers the alignment of set 1 against set 2 of a single job
+  if (vm.count(MEM_LIMIT.c_str())) {
+    p_args.mem_limit = vm[MEM_LIMIT.c_str()].as <boost::uint32_t>();
+    if (p_args.mem_limit > 0 && (p_args.mode != "align" || p_args.jobs != "" || p_args.delta != "" || p_args.extend)) {
+      std::cerr << "The memory limit only plans the alignment of two sets, not serve, --jobs, --delta or --extend!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(AGGREGATE.c_str())) {
+    p_args.aggregate = vm[AGGREGATE.c_str()].as <boost::int32_t>();
+    if (p_args.aggregate < 0 || p_args.aggregate > 2) {
+      std::cerr << "The aggregates have to be one of 0, 1 or 2!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (p_args.aggregate > 0 && (p_args.mode != "align" || p_args.delta != "")) {
+      std::cerr << "The aggregates cannot serve queries or update previous results!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(AGG_BINS.c_str())) {
+    p_args.agg_bins = vm[AGG_BINS.c_str()].as <boost::uint32_t>();
+    if (p_args.agg_bins == 0) {
+      std::cerr << "The histograms of the aggregates need at least one bin!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(AGG_MIN.c_str())) {
+    p_args.agg_min = vm[AGG_MIN.c_str()].as <double>();
+  }
+
+  if (vm.count(AGG_MAX.c_str())) {
+    p_args.agg_max = vm[AGG_MAX.c_str()].as <double>();
+    if (p_args.agg_max <= p_args.agg_min) {
+      std::cerr << "The upper bound of the histograms has to be larger than the lower bound!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vm.count(AGG_THRESHOLDS.c_str()) && vm[AGG_THRESHOLDS.c_str()].as <std::string>() != "") {
+    std::vector<std::string> thresholds;
+    boost::split(thresholds, vm[AGG_THRESHOLDS.c_str()].as <std::string>(), boost::is_any_of(","));
+    try {
+      for (std::vector<std::string>::iterator it = thresholds.begin(); it != thresholds.end(); ++it) {
+        p_args.agg_thresholds.push_back(boost::lexical_cast<double>(*it));
+      }
+    } catch (boost::bad_lexical_cast &) {
+      std::cerr << "The thresholds of the aggregates have to be comma-separated numbers!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!p_job.empty()) {
+    return EXIT_SUCCESS;
+  }
+
+  // the server answers on stdout, so the parameters go to stderr
+  std::ostream &log = (p_args.mode == "serve") ? std::cerr : std::cout;
+  log << argv[0] << " " << PACKAGE_VERSION << std::endl;
+  log << PACKAGE_NAME << std::endl;
+  log << p_args << std::endl;
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,80 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+
+/** @file Extend.cc
+ * Implementation of the extension of the scores of grown sequences.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "Extend.hh"
+#include "Fingerprint.hh"
+
+#include "FrontierStore.hh"
+
+
+bool Extend::apply(const args_t &p_args, ha::SequenceSet &p_set_1, ha::SequenceSet &p_set_2, ha::ScoreSink &p_sink)
+{
+  ha::FrontierStore previous;
+  bool extending = (p_args.previous != "");
+
+  if (extending) {
+    Fingerprint current, prior;
+    current.assign(p_args, m_hierarchy, p_set_1, p_set_2);
+    if (!prior.load(p_args.previous + "/similarity-scores.fp")) {
+      return false;
+    }
+    if (!current.compatible(prior)) {
+      std::cerr << "The previous results were computed from different parameters or hierarchy, recompute them!" << std::endl;
+      return false;
+    }
+    if (!previous.open(p_args.previous + "/similarity-scores.frontiers")) {
+      return false;
+    }
+  }
+
+  // the previous frontiers may be in the results directory, so they are replaced when complete
+  std::string outFile = p_args.results_dir + "/similarity-scores.frontiers";
+  std::string tmpFile = outFile + ".tmp";
+  ha::FrontierStore next;
+  if (!next.create(tmpFile, p_set_1, p_set_2)) {
+    return false;
+  }
+
+  m_aligner.extend(p_set_1, extending ? &previous : NULL, next, p_sink);
+  next.close();
+  previous.close();
+
+  if (std::rename(tmpFile.c_str(), outFile.c_str()) != 0) {
+    std::cerr << "Could not rename " << tmpFile << " to " << outFile << std::endl;
+    std::remove(tmpFile.c_str());
+    return false;
+  }
+
+  return true;
+}
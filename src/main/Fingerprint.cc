@@ -0,0 +1,218 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Fingerprint.cc
+ * Implementation of the fingerprints of the inputs of a score matrix.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+#include "Fingerprint.hh"
+
+#include "Streams.hh"
+
+
+const boost::uint64_t FNV_OFFSET = UINT64_C(14695981039346656037);
+const boost::uint64_t FNV_PRIME = UINT64_C(1099511628211);
+
+/* bytes of the chunks the files are hashed in */
+const std::size_t CHUNK_SIZE = 1 << 16;
+
+
+void Fingerprint::hash(const char *p_data, std::size_t p_size, boost::uint64_t &p_hash)
+{
+  for (std::size_t i = 0; i < p_size; ++i) {
+    p_hash ^= static_cast<unsigned char>(p_data[i]);
+    p_hash *= FNV_PRIME;
+  }
+}
+
+
+void Fingerprint::hash(const std::string &p_str, boost::uint64_t &p_hash)
+{
+  hash(p_str.data(), p_str.size(), p_hash);
+}
+
+
+boost::uint64_t Fingerprint::hash(const common::StringVec &p_seq)
+{
+  boost::uint64_t h = FNV_OFFSET;
+  for (common::StringVec::const_iterator it = p_seq.begin(); it != p_seq.end(); ++it) {
+    hash(it->get(), h);
+    hash(",", h);
+  }
+  return h;
+}
+
+
+void Fingerprint::hash(ha::SequenceSet &p_set, std::vector<boost::uint64_t> &p_hashes)
+{
+  // identical sequences share their hash
+  std::vector<boost::uint64_t> unique(p_set.uniqueSize());
+  for (boost::uint32_t u = 0; u < unique.size(); ++u) {
+    unique[u] = hash(p_set.unique()[u]);
+  }
+
+  p_hashes.resize(p_set.size());
+  for (boost::uint32_t i = 0; i < p_set.size(); ++i) {
+    p_hashes[i] = unique[p_set.id(i)];
+  }
+}
+
+
+bool Fingerprint::hashFile(const std::string &p_filename, boost::uint64_t &p_hash)
+{
+  // the content is hashed, so that compressing a file keeps its hash
+  ha::InputFile file(p_filename);
+  if (!file.is_open()) {
+    std::cerr << "Could not open file: " << p_filename << std::endl;
+    return false;
+  }
+
+  // the file is folded into the hash chunk by chunk, so that it is never held in memory
+  std::vector<char> chunk(CHUNK_SIZE);
+  while (file.read(&chunk[0], chunk.size()) || file.gcount() > 0) {
+    hash(&chunk[0], file.gcount(), p_hash);
+  }
+  if (file.bad()) {
+    std::cerr << "Could not read file: " << p_filename << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+bool Fingerprint::hashHierarchy(const args_t &p_args, boost::uint64_t &p_hash)
+{
+  p_hash = FNV_OFFSET;
+  return hashFile(p_args.euler_levels, p_hash) && hashFile(p_args.euler_positions, p_hash)
+      && hashFile(p_args.lca, p_hash);
+}
+
+
+void Fingerprint::assign(const args_t &p_args, boost::uint64_t p_hierarchy, ha::SequenceSet &p_set_1,
+                         ha::SequenceSet &p_set_2)
+{
+  // only the parameters changing the scores are part of the fingerprint
+  std::ostringstream params;
+  params.precision(std::numeric_limits<double>::digits10 + 2);
+  params << "alg=" << p_args.alg << ",gap_penalty=" << p_args.gap_penalty << ",norm=" << p_args.norm
+         << ",rle=" << p_args.rle << ",seed_k=" << p_args.seed_k << ",seed_level=" << p_args.seed_level
+         << ",seed_min=" << p_args.seed_min << ",coarse_level=" << p_args.coarse_level
+         << ",coarse_min=" << p_args.coarse_min;
+  // the exact scores keep the fingerprints of earlier versions
+  if (p_args.xdrop > 0.0) {
+    params << ",xdrop=" << p_args.xdrop;
+  }
+  if (p_args.alg == 4) {
+    params << ",sketch_k=" << p_args.sketch_k << ",sketch_size=" << p_args.sketch_size
+           << ",sketch_sample=" << p_args.sketch_sample;
+  }
+  m_params = params.str();
+
+  m_hierarchy = p_hierarchy;
+
+  hash(p_set_1, m_set_1);
+  hash(p_set_2, m_set_2);
+}
+
+
+bool Fingerprint::save(const std::string &p_filename) const
+{
+  std::ofstream out(p_filename.c_str(), std::ios::out);
+  if (!out.is_open()) {
+    std::cerr << "Could not open file: " << p_filename << std::endl;
+    return false;
+  }
+
+  out << std::hex;
+  out << "params " << m_params << std::endl;
+  out << "hierarchy " << m_hierarchy << std::endl;
+  out << "set_1 " << std::dec << m_set_1.size() << std::hex << std::endl;
+  for (std::vector<boost::uint64_t>::const_iterator it = m_set_1.begin(); it != m_set_1.end(); ++it) {
+    out << *it << std::endl;
+  }
+  out << "set_2 " << std::dec << m_set_2.size() << std::hex << std::endl;
+  for (std::vector<boost::uint64_t>::const_iterator it = m_set_2.begin(); it != m_set_2.end(); ++it) {
+    out << *it << std::endl;
+  }
+
+  return true;
+}
+
+
+bool Fingerprint::load(const std::string &p_filename)
+{
+  std::ifstream in(p_filename.c_str(), std::ios::in);
+  if (!in.is_open()) {
+    std::cerr << "Could not open file: " << p_filename << std::endl;
+    return false;
+  }
+
+  std::string key;
+  std::size_t n_1 = 0, n_2 = 0;
+
+  in >> key >> m_params;
+  if (key != "params") {
+    std::cerr << "The fingerprint " << p_filename << " does not start with the parameters!" << std::endl;
+    return false;
+  }
+
+  in >> key >> std::hex >> m_hierarchy >> key >> std::dec >> n_1 >> std::hex;
+  m_set_1.resize(n_1);
+  for (std::size_t i = 0; i < n_1; ++i) {
+    in >> m_set_1[i];
+  }
+
+  in >> key >> std::dec >> n_2 >> std::hex;
+  m_set_2.resize(n_2);
+  for (std::size_t j = 0; j < n_2; ++j) {
+    in >> m_set_2[j];
+  }
+
+  if (in.fail()) {
+    std::cerr << "The fingerprint " << p_filename << " is truncated!" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+bool Fingerprint::matches(const Fingerprint &p_other, bool p_set_2) const
+{
+  return m_params == p_other.m_params && m_hierarchy == p_other.m_hierarchy && m_set_1 == p_other.m_set_1
+      && (!p_set_2 || m_set_2 == p_other.m_set_2);
+}
+
+
+bool Fingerprint::compatible(const Fingerprint &p_other) const
+{
+  return m_params == p_other.m_params && m_hierarchy == p_other.m_hierarchy;
+}
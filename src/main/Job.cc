@@ -0,0 +1,267 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Job.cc
+ * Implementation of the comparison of two sets.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Extend.hh"
+#include "Fingerprint.hh"
+#include "Job.hh"
+#include "Update.hh"
+
+#include "AggregateSink.hh"
+#include "AlignmentWriter.hh"
+#include "SequenceSet.hh"
+#include "Streams.hh"
+
+
+/** @class FileSink
+ * This class writes the scores of every pair of positions to a file, one score per line.
+ */
+class FileSink : public ha::ScoreSink
+{
+ public:
+  FileSink(std::ostream &p_out) : m_out(p_out) {}
+
+  void write(boost::uint32_t, ha::SequenceSet &p_targets, const std::vector<double> &p_scores)
+  {
+    // fan the unique scores out to the original positions of the targets
+    for (boost::uint32_t j = 0; j < p_targets.size(); ++j) {
+      m_out << p_scores[p_targets.id(j)] << std::endl;
+    }
+  }
+
+ private:
+  std::ostream &m_out;
+};
+
+
+ha::alignOptions Job::options(const args_t &p_args)
+{
+  ha::alignOptions options;
+  options.alg = p_args.alg;
+  options.scores = p_args.scores;
+  options.gap_penalty = p_args.gap_penalty;
+  options.rle = p_args.rle;
+  options.norm = p_args.norm;
+  options.seed_k = p_args.seed_k;
+  options.seed_level = p_args.seed_level;
+  options.seed_min = p_args.seed_min;
+  options.coarse_level = p_args.coarse_level;
+  options.coarse_min = p_args.coarse_min;
+  options.xdrop = p_args.xdrop;
+  options.numa = p_args.numa;
+  options.huge_pages = p_args.huge_pages;
+  options.dp_cap = static_cast<boost::uint64_t>(p_args.dp_cap) << 20;
+  options.wavefront = static_cast<boost::uint64_t>(p_args.wavefront) * 1000000;
+  options.wavefront_tile = p_args.wavefront_tile;
+  options.sweep = p_args.sweep;
+  options.trie = p_args.trie;
+  options.sketch_k = p_args.sketch_k;
+  options.sketch_size = p_args.sketch_size;
+  options.sketch_sample = p_args.sketch_sample;
+
+  return options;
+}
+
+
+bool Job::load(const args_t &p_args, ha::SequenceSet &p_seqs_1, ha::SequenceSet &p_seqs_2, std::ostream &p_report)
+{
+  if (!p_seqs_1.load(p_args.set_1) || !p_seqs_2.load(p_args.set_2)) {
+    return false;
+  }
+
+  p_report << "Set 1: " << p_seqs_1.size() << " sequences, " << p_seqs_1.uniqueSize() << " unique" << std::endl;
+  p_report << "Set 2: " << p_seqs_2.size() << " sequences, " << p_seqs_2.uniqueSize() << " unique" << std::endl;
+
+  return true;
+}
+
+
+bool Job::apply(const args_t &p_args, std::ostream &p_report)
+{
+  ha::SequenceSet seqs_1, seqs_2;
+  if (!load(p_args, seqs_1, seqs_2, p_report)) {
+    return false;
+  }
+
+  return apply(p_args, seqs_1, seqs_2, p_report);
+}
+
+
+bool Job::apply(const args_t &p_args, ha::SequenceSet &p_seqs_1, ha::SequenceSet &p_seqs_2, std::ostream &p_report)
+{
+  if (p_args.delta != "") {
+    Update update(m_aligner, m_hierarchy);
+    return update.apply(p_args, p_seqs_1, p_seqs_2, p_report);
+  }
+
+  ha::codec_t codec = ha::PLAIN;
+  ha::OutputFile::codec(p_args.compress, codec);
+
+  // a sweep writes one score matrix and one file of aggregates per algorithm and gap penalty
+  std::vector<std::string> outFiles;
+  for (boost::uint32_t k = 0; k < m_aligner.lanes(); ++k) {
+    std::ostringstream outFile;
+    outFile << p_args.results_dir << "/similarity-scores";
+    if (p_args.alg == 3) {
+      outFile << (m_aligner.lane(k).local ? ".sw" : ".nw");
+    }
+    if (!p_args.sweep.empty()) {
+      outFile << ".gap_" << m_aligner.lane(k).delta;
+    }
+    outFiles.push_back(outFile.str());
+  }
+
+  // the aggregates receive the scores first and pass them on to the matrix, if any
+  std::vector<boost::shared_ptr<ha::OutputFile> > outs;
+  std::vector<boost::shared_ptr<ha::ScoreSink> > ownedSinks;
+  std::vector<ha::ScoreSink*> sinks;
+  for (boost::uint32_t k = 0; k < outFiles.size(); ++k) {
+    ha::ScoreSink *sink = NULL;
+    if (p_args.aggregate != 2) {
+      outs.push_back(boost::shared_ptr<ha::OutputFile>(new ha::OutputFile));
+      if (!outs.back()->open(outFiles[k] + ".dat", codec, p_args.compress_threads)) {
+        std::cerr << "Could not open file: " << outFiles[k] << ".dat" << ha::OutputFile::extension(codec) << std::endl;
+        return false;
+      }
+      ownedSinks.push_back(boost::shared_ptr<ha::ScoreSink>(new FileSink(*outs.back())));
+      sink = ownedSinks.back().get();
+    }
+    if (p_args.aggregate > 0) {
+      outs.push_back(boost::shared_ptr<ha::OutputFile>(new ha::OutputFile));
+      if (!outs.back()->open(outFiles[k] + ".agg", codec, p_args.compress_threads)) {
+        std::cerr << "Could not open file: " << outFiles[k] << ".agg" << ha::OutputFile::extension(codec) << std::endl;
+        return false;
+      }
+      ownedSinks.push_back(boost::shared_ptr<ha::ScoreSink>(
+          new ha::AggregateSink(*outs.back(), sink, p_args.agg_bins, p_args.agg_min, p_args.agg_max, p_args.agg_thresholds)));
+      sink = ownedSinks.back().get();
+    }
+    sinks.push_back(sink);
+  }
+
+  // the alignments are streamed by a writer thread while the scores are computed
+  ha::OutputFile alignmentsOut;
+  boost::scoped_ptr<ha::AlignmentWriter> writer;
+  if (p_args.alignments != "") {
+    bool binary = (p_args.alignments == "binary");
+    std::string alignmentsFile = p_args.results_dir + "/alignments." + (binary ? "bin" : "tsv");
+    if (!alignmentsOut.open(alignmentsFile, codec, p_args.compress_threads)) {
+      std::cerr << "Could not open file: " << alignmentsFile << ha::OutputFile::extension(codec) << std::endl;
+      return false;
+    }
+    writer.reset(new ha::AlignmentWriter(alignmentsOut, binary));
+    m_aligner.traces(writer.get());
+
+    // the LCAs of the alignments refer to the line numbers of the symbol table, starting at 0
+    std::string symbolsFile = p_args.results_dir + "/alignments.symbols";
+    std::ofstream symbolsOut(symbolsFile.c_str(), std::ios::out);
+    for (boost::uint32_t k = 0; k < m_aligner.scheme().size(); ++k) {
+      symbolsOut << m_aligner.scheme().symbol(k) << std::endl;
+    }
+  }
+
+  m_aligner.index(p_seqs_2);
+  if (p_args.extend) {
+    Extend extend(m_aligner, m_hierarchy);
+    if (!extend.apply(p_args, p_seqs_1, p_seqs_2, *sinks[0])) {
+      return false;
+    }
+  } else {
+    m_aligner.align(p_seqs_1, sinks);
+  }
+  m_aligner.traces(NULL);
+
+  // the writer has to finish before the last block of the alignments is compressed
+  writer.reset();
+  alignmentsOut.close();
+  bool written = !alignmentsOut.fail();
+  for (boost::uint32_t k = 0; k < outs.size(); ++k) {
+    outs[k]->close();
+    written = written && !outs[k]->fail();
+  }
+  if (!written) {
+    std::cerr << "Could not write the results to: " << p_args.results_dir << std::endl;
+    return false;
+  }
+
+  // the fingerprint allows later runs to update the matrix instead of recomputing it
+  if (p_args.sweep.empty() && p_args.alg != 3 && p_args.aggregate != 2) {
+    Fingerprint fingerprint;
+    fingerprint.assign(p_args, m_hierarchy, p_seqs_1, p_seqs_2);
+    if (!fingerprint.save(p_args.results_dir + "/similarity-scores.fp")) {
+      return false;
+    }
+  }
+
+  const ha::alignStats &stats = m_aligner.stats();
+  if (p_args.alg == 4) {
+    // only the sampled pairs are aligned, all others compare their sketches
+    p_report << "Aligned " << stats.sampledPairs << " sampled pairs, approximated " << stats.approximatedPairs
+             << " of " << stats.pairs << " unique pairs" << std::endl;
+  } else {
+    p_report << "Aligned " << stats.candidates << " of " << stats.pairs << " unique pairs" << std::endl;
+  }
+  if (p_args.coarse_level > 0) {
+    p_report << "Filtered " << stats.coarseFiltered << " pairs at the coarse level" << std::endl;
+  }
+  if (p_args.xdrop > 0.0) {
+    p_report << "Skipped " << stats.skippedCells << " cells by the X-drop" << std::endl;
+  }
+  if (p_args.alg == 4 && stats.sampledPairs > 0) {
+    p_report << "Approximated the scores, errors of the held-out half of " << stats.sampledPairs << " sampled pairs: mean "
+             << stats.sampleMeanError << ", rms " << stats.sampleRmsError << ", 95% "
+             << stats.sampleP95Error << std::endl;
+  }
+  if (p_args.trie) {
+    p_report << "Shared " << stats.sharedRows << " rows by the prefix trie" << std::endl;
+  }
+  if (p_args.extend) {
+    p_report << "Reused " << stats.reusedCells << " cells of the previous frontiers" << std::endl;
+  }
+  if (p_args.dp_cap > 0 || stats.cappedPairs > 0) {
+    p_report << "Scored " << stats.cappedPairs << " pairs in linear space" << std::endl;
+  }
+  if (stats.wavefrontPairs > 0) {
+    p_report << "Scored " << stats.wavefrontPairs << " pairs by the wavefront" << std::endl;
+  }
+  if (stats.recomputedRows > 0) {
+    p_report << "Recomputed " << stats.recomputedRows << " rows beyond the row cache" << std::endl;
+  }
+
+  return true;
+}
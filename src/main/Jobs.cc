@@ -0,0 +1,212 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Jobs.cc
+ * Implementation of the comparisons of a manifest of jobs against one hierarchy.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+#ifdef _OPENMP
+# include <omp.h>
+#endif /* _OPENMP */
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/filesystem.hpp>
+namespace fs = boost::filesystem;
+
+#include <boost/program_options/errors.hpp>
+
+#include "Fingerprint.hh"
+#include "Job.hh"
+#include "Jobs.hh"
+
+#include "Aligner.hh"
+
+
+bool Jobs::apply(CL &p_cl, int argc, char *argv[], const args_t &p_args)
+{
+  std::vector<job_t> jobs;
+  if (!read(p_cl, argc, argv, p_args, jobs)) {
+    return false;
+  }
+
+  // the scoring scheme only depends on the hierarchy and the gap penalty
+  Schemes schemes;
+  boost::uint64_t total = 0;
+  for (std::vector<job_t>::iterator it = jobs.begin(); it != jobs.end(); ++it) {
+    if (schemes.find(it->args.gap_penalty) == schemes.end()) {
+      schemes[it->args.gap_penalty] = ha::Aligner::createScheme(m_hierarchy, Job::options(it->args));
+    }
+    total += it->cost;
+  }
+
+  // the hierarchy files are hashed once for the fingerprints of all jobs
+  boost::uint64_t hierarchy;
+  if (!Fingerprint::hashHierarchy(p_args, hierarchy)) {
+    return false;
+  }
+
+#ifdef _OPENMP
+  boost::uint64_t threads = omp_get_max_threads();
+#else
+  boost::uint64_t threads = 1;
+#endif /* _OPENMP */
+
+  // the largest jobs first, the jobs of the same cost in the order of the manifest
+  std::vector<boost::uint32_t> large, small;
+  for (boost::uint32_t k = 0; k < jobs.size(); ++k) {
+    ((threads > 1 && jobs[k].cost >= total / threads) ? large : small).push_back(k);
+  }
+  struct ByCost {
+    const std::vector<job_t> &jobs;
+    bool operator()(boost::uint32_t a, boost::uint32_t b) const { return jobs[a].cost > jobs[b].cost; }
+  } byCost = { jobs };
+  std::stable_sort(large.begin(), large.end(), byCost);
+  std::stable_sort(small.begin(), small.end(), byCost);
+
+  std::cout << "Jobs: " << jobs.size() << ", " << large.size() << " run by all workers, "
+            << small.size() << " dealt out to the workers" << std::endl;
+
+  boost::uint32_t failed = 0;
+  for (std::vector<boost::uint32_t>::iterator it = large.begin(); it != large.end(); ++it) {
+    failed += !run(jobs[*it], true, schemes, hierarchy);
+  }
+
+#ifdef _OPENMP
+  // the parallel regions of the aligners of the small jobs run on the worker of their job
+  omp_set_max_active_levels(1);
+#endif /* _OPENMP */
+
+  #pragma omp parallel for schedule(dynamic, 1) shared(jobs, small, schemes, hierarchy) reduction(+:failed) default(none)
+  for (boost::uint32_t k = 0; k < small.size(); ++k) {
+    failed += !run(jobs[small[k]], false, schemes, hierarchy);
+  }
+
+  if (failed > 0) {
+    std::cerr << failed << " of " << jobs.size() << " jobs failed!" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+bool Jobs::read(CL &p_cl, int argc, char *argv[], const args_t &p_args, std::vector<job_t> &p_jobs) const
+{
+  std::ifstream in(p_args.jobs.c_str(), std::ios::in);
+  if (!in.is_open()) {
+    std::cerr << "Could not open file: " << p_args.jobs << std::endl;
+    return false;
+  }
+
+  std::set<std::string> results;
+  std::string line;
+  boost::uint32_t number = 0;
+  while (std::getline(in, line)) {
+    ++number;
+
+    std::string::size_type comment = line.find('#');
+    if (comment != std::string::npos) {
+      line.erase(comment);
+    }
+    std::vector<std::string> tokens, options;
+    boost::split(tokens, line, boost::is_any_of(" \t\r"), boost::token_compress_on);
+    for (std::vector<std::string>::iterator it = tokens.begin(); it != tokens.end(); ++it) {
+      if (!it->empty()) {
+        options.push_back(*it);
+      }
+    }
+    if (options.empty()) {
+      continue;
+    }
+
+    job_t job;
+    job.line = number;
+    try {
+      if (p_cl.parse(argc, argv, options, job.args) != EXIT_SUCCESS) {
+        std::cerr << "The job in line " << number << " of " << p_args.jobs << " is invalid!" << std::endl;
+        return false;
+      }
+    } catch (po::error &e) {
+      std::cerr << "The job in line " << number << " of " << p_args.jobs << " is invalid: " << e.what() << std::endl;
+      return false;
+    }
+
+    // the hierarchy and the pages are loaded once for all jobs
+    if (job.args.jobs != p_args.jobs || job.args.euler_levels != p_args.euler_levels
+        || job.args.euler_positions != p_args.euler_positions || job.args.lca != p_args.lca
+        || job.args.huge_pages != p_args.huge_pages) {
+      std::cerr << "The job in line " << number << " of " << p_args.jobs
+                << " cannot change the manifest, the hierarchy or the pages!" << std::endl;
+      return false;
+    }
+    if (job.args.set_1 == "" || job.args.set_2 == "") {
+      std::cerr << "The job in line " << number << " of " << p_args.jobs << " needs --set_1 and --set_2!" << std::endl;
+      return false;
+    }
+    if (!results.insert(job.args.results_dir).second) {
+      std::cerr << "The job in line " << number << " of " << p_args.jobs << " writes to the results directory "
+                << job.args.results_dir << " of another job!" << std::endl;
+      return false;
+    }
+
+    // the cells of all pairs grow with the product of the sizes of the sets
+    job.cost = static_cast<boost::uint64_t>(fs::file_size(job.args.set_1) + 1) * (fs::file_size(job.args.set_2) + 1);
+    p_jobs.push_back(job);
+  }
+
+  return true;
+}
+
+
+bool Jobs::run(const job_t &p_job, bool p_shared, const Schemes &p_schemes, boost::uint64_t p_hierarchy)
+{
+  // a job of a single worker is not placed, all jobs would be pinned to the first node
+  ha::alignOptions options = Job::options(p_job.args);
+  options.numa = options.numa && p_shared;
+
+  std::ostringstream report;
+  bool done;
+  {
+    ha::Aligner aligner(m_hierarchy, options, p_schemes.find(p_job.args.gap_penalty)->second);
+    Job job(aligner, p_hierarchy);
+    done = job.apply(p_job.args, report);
+  }
+
+  #pragma omp critical (report)
+  {
+    std::cout << "Job " << p_job.line << ": " << p_job.args.set_1 << " against " << p_job.args.set_2
+              << " into " << p_job.args.results_dir << (done ? "" : " failed") << std::endl
+              << report.str();
+  }
+
+  return done;
+}
@@ -0,0 +1,335 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Plan.cc
+ * Implementation of the plan of a comparison within a memory limit.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+# include <omp.h>
+#endif /* _OPENMP */
+
+#include "Plan.hh"
+
+#include "MemoryPool.hh"
+
+#include "AlignmentWriter.hh"
+#include "Streams.hh"
+#include "Topology.hh"
+
+
+/* bytes of a MiB */
+static const boost::uint64_t MIB = 1 << 20;
+
+/* bytes of the process itself: the binary, the libraries and the stacks of the threads */
+static const boost::uint64_t PROCESS = 8 * MIB;
+
+/* bytes of a node of a std::map besides its value */
+static const boost::uint64_t MAP_NODE = 32;
+
+/* bytes of a node of a hash map besides its value */
+static const boost::uint64_t HASH_NODE = 32;
+
+/* bytes of a symbol of the alphabet in the flyweight table */
+static const boost::uint64_t SYMBOL = sizeof(std::string) + 16;
+
+/* bytes of a pair of symbols in the table of the scoring scheme */
+static const boost::uint64_t PAIR = 24;
+
+/* bytes of a node of the prefix trie */
+static const boost::uint64_t TRIE_NODE = 32;
+
+
+/** @return the bytes rounded up to MiB */
+static boost::uint64_t mib(boost::uint64_t p_bytes)
+{
+  return (p_bytes + MIB - 1) / MIB;
+}
+
+
+bool Plan::apply(const args_t &p_args, ha::SequenceSet &p_seqs_1, ha::SequenceSet &p_seqs_2,
+                 ha::alignOptions &p_options, std::ostream &p_report)
+{
+  boost::uint64_t limit = static_cast<boost::uint64_t>(p_args.mem_limit) * MIB;
+
+#ifdef _OPENMP
+  boost::uint32_t threads = omp_get_max_threads();
+#else
+  boost::uint32_t threads = 1;
+#endif /* _OPENMP */
+
+  bool sweep = !p_options.sweep.empty() || p_options.alg == 3;
+  boost::uint32_t lanes = ((p_options.alg == 3) ? 2 : 1) * std::max<std::size_t>(p_options.sweep.size(), 1);
+  bool traced = (p_args.alignments != "") && !p_options.scores;
+
+  // every NUMA node keeps its own copy of the scoring scheme, set 2 and the profiles
+  boost::uint32_t replicas = 1;
+  if (p_options.numa) {
+    ha::Topology topology;
+    if (topology.load()) {
+      replicas = std::min(topology.nodes(), threads);
+    }
+  }
+
+  // the matrices grow with the longest pair
+  boost::uint32_t rows = longest(p_seqs_1) + 1;
+  boost::uint32_t cols = longest(p_seqs_2) + 1;
+  boost::uint64_t symbols_2 = symbols(p_seqs_2);
+
+  boost::uint64_t hierarchyBytes = hierarchy() + replicas * scheme();
+
+  // the sets, the copies of set 2 on the other nodes, the targets encoded
+  // into the alphabet and the seeds and coarse sequences of set 2
+  boost::uint64_t setBytes = sequences(p_seqs_1) + replicas * sequences(p_seqs_2)
+      + replicas * symbols_2 * sizeof(boost::uint32_t);
+  if (p_options.seed_k > 0) {
+    setBytes += symbols_2 * 2 * sizeof(boost::uint32_t);
+  }
+  if (p_options.coarse_level > 0) {
+    setBytes += (symbols(p_seqs_1) + symbols_2) * sizeof(common::Symbol);
+  }
+  if (p_options.norm == 3) {
+    setBytes += (p_seqs_1.uniqueSize() + p_seqs_2.uniqueSize()) * lanes * sizeof(double);
+  }
+
+  // the profile of the current query against the alphabet
+  setBytes += replicas * static_cast<boost::uint64_t>(rows) * m_hierarchy.positions().size() * sizeof(double);
+
+  // the compressed outputs queue two blocks per compressing thread
+  if (p_args.compress != "") {
+    boost::uint64_t files = ((p_args.aggregate != 2) ? lanes : 0) + ((p_args.aggregate > 0) ? lanes : 0)
+        + ((p_args.alignments != "") ? 1 : 0);
+    setBytes += files * (2 * p_args.compress_threads + 1) * 2 * ha::BlockBuffer::BLOCK_SIZE;
+  }
+
+  // the writer of the alignments queues full buffers, keeps the written
+  // ones for reuse, fills one per worker and fans the pairs out to the positions
+  if (traced) {
+    setBytes += (ha::AlignmentWriter::QUEUE_SIZE + 1 + threads) * ha::AlignmentWriter::BUFFER_SIZE
+        + (p_seqs_1.size() + p_seqs_2.size()) * sizeof(boost::uint32_t)
+        + (p_seqs_1.uniqueSize() + p_seqs_2.uniqueSize()) * sizeof(std::vector<boost::uint32_t>);
+  }
+
+  boost::uint64_t fixed = PROCESS + hierarchyBytes + setBytes;
+  boost::uint64_t row = static_cast<boost::uint64_t>(lanes) * p_seqs_2.uniqueSize() * sizeof(double);
+  if (fixed + row > limit) {
+    std::cerr << "The hierarchy and the sets alone need about " << mib(fixed + row)
+              << " MiB, more than the memory limit of " << p_args.mem_limit << " MiB!" << std::endl;
+    return false;
+  }
+  boost::uint64_t avail = limit - fixed;
+
+  // the rows of scores get at most half of the memory left
+  boost::uint64_t rowBytes = 0;
+  if (p_options.trie) {
+    rowBytes = static_cast<boost::uint64_t>(p_seqs_1.uniqueSize()) * p_seqs_2.uniqueSize() * sizeof(double)
+        + symbols(p_seqs_1) * TRIE_NODE;
+    p_options.trie = (rowBytes <= avail / 2);
+  }
+  if (!p_options.trie) {
+    rowBytes = live(p_seqs_1) * row;
+    if (rowBytes > avail / 2 && !traced) {
+      // the rows beyond the cache are computed again at the next position of their query
+      p_options.row_cache = std::max(avail / 2, row + 1) - row;
+      rowBytes = p_options.row_cache + row;
+    }
+  }
+
+  // the self-alignments of --norm 3 and the calibration of --alg 4 align
+  // the longest sequence of either set with itself in the same matrices
+  boost::uint32_t self = (p_options.norm == 3 || p_options.alg == 4) ? std::max(rows, cols) : 0;
+
+  // the matrices of a worker: the longest pair, its rows in the sweep, or
+  // the runs of the run-length encoded scores
+  bool cappable = !sweep && !(p_options.rle && p_options.scores);
+  boost::uint64_t full = std::max(static_cast<boost::uint64_t>(rows) * cols, static_cast<boost::uint64_t>(self) * self)
+      * alignment::MemoryPool::CELL;
+  if (sweep) {
+    full = 3 * static_cast<boost::uint64_t>(std::max(cols, self)) * lanes * alignment::MemoryPool::CELL;
+  } else if (p_options.rle && p_options.scores) {
+    full = 5 * static_cast<boost::uint64_t>(std::max(rows, cols)) * alignment::MemoryPool::CELL;
+  }
+  boost::uint64_t linear = 2 * static_cast<boost::uint64_t>(std::max(cols, self)) * alignment::MemoryPool::CELL;
+
+  boost::uint64_t workers = (rowBytes < avail) ? avail - rowBytes : 0;
+
+  // the longest pair is scored by all workers together, if it is not aligned
+  bool tiled = (p_options.wavefront > 0) && !sweep && p_options.alg != 4 && !p_options.rle && p_options.xdrop == 0.0
+      && static_cast<boost::uint64_t>(rows - 1) * (cols - 1) >= p_options.wavefront;
+  boost::uint32_t tile = p_options.wavefront_tile;
+  while (tiled && tile < std::max(rows, cols) && wavefront(rows - 1, cols - 1, tile, threads) > workers / 2) {
+    tile *= 2;
+  }
+  boost::uint64_t tiles = tiled ? wavefront(rows - 1, cols - 1, tile, threads) : 0;
+
+  std::string kernel = p_options.scores ? "score-only" : "full traceback";
+  boost::uint64_t worker = full;
+  if (threads * full + (p_options.scores ? tiles : 0) <= workers) {
+    tiles = p_options.scores ? tiles : 0;
+  } else if (traced && full <= workers) {
+    // fewer workers keep the alignments of all pairs
+    threads = workers / full;
+    tiles = 0;
+  } else if (!cappable) {
+    threads = (full + tiles <= workers) ? (workers - tiles) / full : 0;
+  } else {
+    worker = (tiles < workers) ? (workers - tiles) / threads : 0;
+    if (worker < linear) {
+      threads = (linear + tiles <= workers) ? (workers - tiles) / linear : 0;
+      worker = linear;
+    }
+  }
+
+  // the matrices are capped in any case, so that the geometric growth of
+  // the matrices allocated on demand does not exceed the share of a worker
+  p_options.dp_cap = (p_options.dp_cap > 0) ? std::min(p_options.dp_cap, worker) : worker;
+  if (cappable && p_options.dp_cap < full) {
+    kernel = "linear-space";
+  }
+
+  if (threads == 0) {
+    std::cerr << "The comparison needs about " << mib(fixed + rowBytes + tiles + std::min(full, cappable ? linear : full))
+              << " MiB, more than the memory limit of " << p_args.mem_limit << " MiB!" << std::endl;
+    return false;
+  }
+  p_options.wavefront_tile = tile;
+
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif /* _OPENMP */
+
+  p_report << "Memory estimate: process " << mib(PROCESS) << " MiB, hierarchy " << mib(hierarchyBytes) << " MiB, sets " << mib(setBytes)
+           << " MiB, rows " << mib(rowBytes) << " MiB, workers " << threads << " x " << mib(worker)
+           << " MiB, wavefront " << mib(tiles) << " MiB of " << p_args.mem_limit << " MiB" << std::endl;
+  p_report << "Plan: threads " << threads << ", kernel " << kernel;
+  if (kernel == "linear-space") {
+    p_report << " beyond " << mib(p_options.dp_cap) << " MiB per worker";
+  }
+  if (tiles > 0) {
+    p_report << ", tiles " << tile;
+  }
+  if (p_options.row_cache > 0) {
+    p_report << ", rows of set 1 streamed through " << mib(p_options.row_cache) << " MiB";
+  } else {
+    p_report << ", rows of set 1 kept";
+  }
+  if (p_args.trie && !p_options.trie) {
+    p_report << ", prefix trie off";
+  }
+  p_report << std::endl;
+
+  return true;
+}
+
+
+boost::uint64_t Plan::hierarchy() const
+{
+  return m_hierarchy.levels().size() * sizeof(double)
+      + m_hierarchy.positions().size() * (MAP_NODE + sizeof(common::Symbol) + sizeof(boost::uint32_t) + SYMBOL)
+      + m_hierarchy.lcas().size() * (MAP_NODE + 3 * sizeof(common::Symbol));
+}
+
+
+boost::uint64_t Plan::scheme() const
+{
+  // the table of the pairs is at most half full
+  boost::uint64_t slots = 2;
+  while (slots < 2 * m_hierarchy.lcas().size()) {
+    slots <<= 1;
+  }
+
+  return slots * PAIR + m_hierarchy.positions().size() * (HASH_NODE + sizeof(common::Symbol) + sizeof(boost::uint32_t));
+}
+
+
+boost::uint64_t Plan::symbols(ha::SequenceSet &p_seqs)
+{
+  boost::uint64_t symbols = 0;
+  for (common::Sequences::const_iterator it = p_seqs.unique().begin(); it != p_seqs.unique().end(); ++it) {
+    symbols += it->size();
+  }
+
+  return symbols;
+}
+
+
+boost::uint32_t Plan::longest(ha::SequenceSet &p_seqs)
+{
+  boost::uint32_t longest = 0;
+  for (common::Sequences::const_iterator it = p_seqs.unique().begin(); it != p_seqs.unique().end(); ++it) {
+    longest = std::max<boost::uint32_t>(longest, it->size());
+  }
+
+  return longest;
+}
+
+
+boost::uint64_t Plan::sequences(ha::SequenceSet &p_seqs)
+{
+  // every unique sequence is kept twice, once as the key of its ID
+  return 2 * (p_seqs.uniqueSize() * sizeof(common::StringVec) + symbols(p_seqs) * sizeof(common::Symbol))
+      + p_seqs.uniqueSize() * (HASH_NODE + sizeof(boost::uint32_t)) + p_seqs.size() * sizeof(boost::uint32_t);
+}
+
+
+boost::uint32_t Plan::live(ha::SequenceSet &p_seqs)
+{
+  // a row is kept from the first to the last position of its query
+  std::vector<boost::uint32_t> pending(p_seqs.uniqueSize());
+  for (boost::uint32_t u = 0; u < pending.size(); ++u) {
+    pending[u] = p_seqs.multiplicity(u);
+  }
+  std::vector<bool> seen(p_seqs.uniqueSize(), false);
+
+  boost::uint32_t live = 0, peak = 0;
+  for (std::size_t i = 0; i < p_seqs.size(); ++i) {
+    boost::uint32_t u = p_seqs.id(i);
+    if (!seen[u]) {
+      seen[u] = true;
+      peak = std::max(peak, ++live);
+    }
+    live -= (--pending[u] == 0);
+  }
+
+  return peak;
+}
+
+
+boost::uint64_t Plan::wavefront(boost::uint32_t p_rows, boost::uint32_t p_cols, boost::uint32_t p_tile,
+                                boost::uint32_t p_threads)
+{
+  // the last row and column of the tiles, their corners, the rows of every
+  // thread within a tile and the counters of the rows of tiles
+  boost::uint64_t rows = (p_rows + p_tile - 1) / p_tile;
+  boost::uint64_t cols = (p_cols + p_tile - 1) / p_tile;
+
+  return (static_cast<boost::uint64_t>(p_rows) + p_cols + 2 + rows * cols + p_threads) * sizeof(double)
+      + static_cast<boost::uint64_t>(p_threads) * 2 * (p_tile + 1) * sizeof(double) + rows * sizeof(boost::uint32_t);
+}
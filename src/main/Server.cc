@@ -0,0 +1,110 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Server.cc
+ * Implementation of the persistent query server.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <cstdio>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include <boost/asio.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/system/system_error.hpp>
+
+#include "Server.hh"
+
+
+Server::Server(ha::Aligner &p_aligner, ha::SequenceSet &p_targets, boost::uint32_t p_k)
+    : m_aligner(p_aligner), m_k(p_k)
+{
+  m_aligner.index(p_targets);
+}
+
+
+void Server::serve(std::istream &p_in, std::ostream &p_out)
+{
+  std::string line;
+  while (std::getline(p_in, line)) {
+    boost::algorithm::trim(line);
+    if (line == "") {
+      continue;
+    }
+
+    // every request is a batch of one query against the indexed targets
+    ha::SequenceSet query;
+    common::StringVec seq;
+    ha::SequenceSet::parse(line, seq);
+    query.add(seq);
+
+    ha::TopKSink sink(m_k);
+    m_aligner.align(query, sink);
+
+    const std::vector<ha::TopKSink::match_t> &matches = sink.matches(0);
+    for (std::vector<ha::TopKSink::match_t>::const_iterator it = matches.begin(); it != matches.end(); ++it) {
+      p_out << it->first << "\t" << it->second << "\n";
+    }
+    p_out << std::endl;
+  }
+}
+
+
+bool Server::listen(const std::string &p_path)
+{
+  typedef boost::asio::local::stream_protocol protocol;
+
+  boost::asio::io_service io;
+  boost::scoped_ptr<protocol::acceptor> acceptor;
+
+  // only a stale socket of an earlier server is replaced, never any other file
+  struct stat status;
+  if (lstat(p_path.c_str(), &status) == 0) {
+    if (!S_ISSOCK(status.st_mode)) {
+      std::cerr << "Could not listen on socket " << p_path << ": the file exists and is not a socket!" << std::endl;
+      return false;
+    }
+    std::remove(p_path.c_str());
+  }
+  try {
+    acceptor.reset(new protocol::acceptor(io, protocol::endpoint(p_path)));
+  } catch (boost::system::system_error &e) {
+    std::cerr << "Could not listen on socket " << p_path << ": " << e.what() << std::endl;
+    return false;
+  }
+
+  std::cerr << "Listening on " << p_path << std::endl;
+
+  for (;;) {
+    protocol::iostream stream;
+    boost::system::error_code ec;
+    acceptor->accept(*stream.rdbuf(), ec);
+    if (!ec) {
+      serve(stream, stream);
+    }
+  }
+}
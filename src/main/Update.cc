@@ -0,0 +1,200 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Update.cc
+ * Implementation of the incremental update of a score matrix.
+ *
+ * @author Dominik Dahlem
+ */
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/algorithm/string/trim.hpp>
+
+#include "Fingerprint.hh"
+#include "Update.hh"
+
+#include "Streams.hh"
+
+
+/* the codecs of the score matrices, in the order the previous matrix is looked up */
+static const ha::codec_t CODECS[] = { ha::PLAIN, ha::GZIP, ha::ZSTD };
+
+
+static std::ostream& writeSequence(std::ostream &p_os, const common::StringVec &p_seq)
+{
+  for (boost::uint32_t k = 0; k < p_seq.size(); ++k) {
+    p_os << ((k > 0) ? "," : "") << p_seq[k];
+  }
+  return p_os;
+}
+
+
+bool Update::apply(const args_t &p_args, ha::SequenceSet &p_set_1, ha::SequenceSet &p_set_2, std::ostream &p_report)
+{
+  Fingerprint current, previous;
+  current.assign(p_args, m_hierarchy, p_set_1, p_set_2);
+  if (!previous.load(p_args.previous + "/similarity-scores.fp")) {
+    return false;
+  }
+  if (!current.matches(previous, true)) {
+    std::cerr << "The previous results were computed from different parameters, hierarchy or sets, recompute them!" << std::endl;
+    return false;
+  }
+
+  ha::InputFile deltaFile(p_args.delta);
+  if (!deltaFile.is_open()) {
+    std::cerr << "Could not open file: " << p_args.delta << std::endl;
+    return false;
+  }
+
+  // the positions of set 2 in input order per unique ID
+  std::vector<std::vector<boost::uint32_t> > occurrences(p_set_2.uniqueSize());
+  for (boost::uint32_t j = 0; j < p_set_2.size(); ++j) {
+    occurrences[p_set_2.id(j)].push_back(j);
+  }
+  std::vector<boost::uint32_t> removed(p_set_2.uniqueSize(), 0);
+  std::vector<bool> keep(p_set_2.size(), true);
+
+  ha::SequenceSet added;
+  std::string line;
+  while (std::getline(deltaFile, line)) {
+    boost::algorithm::trim(line);
+    if (line == "") {
+      continue;
+    }
+
+    common::StringVec seq;
+    ha::SequenceSet::parse(line.substr(1), seq);
+
+    if (line[0] == '+') {
+      added.add(seq);
+    } else if (line[0] == '-') {
+      boost::uint32_t id;
+      if (!p_set_2.find(seq, id) || removed[id] == occurrences[id].size()) {
+        std::cerr << "The removed sequence is not part of set 2: " << line.substr(1) << std::endl;
+        return false;
+      }
+      keep[occurrences[id][removed[id]++]] = false;
+    } else {
+      std::cerr << "Each line of the delta file has to start with + or -, got: " << line << std::endl;
+      return false;
+    }
+  }
+
+  // only set 1 against the appended sequences is aligned
+  ha::ScoreMatrix scores;
+  if (added.size() > 0) {
+    m_aligner.align(p_set_1, added, scores);
+  }
+
+  ha::codec_t codec = ha::PLAIN;
+  ha::OutputFile::codec(p_args.compress, codec);
+
+  // the previous matrix may have been written with any codec
+  std::string prevFile = p_args.previous + "/similarity-scores.dat";
+  for (boost::uint32_t c = 0; c < sizeof(CODECS) / sizeof(CODECS[0]); ++c) {
+    std::ifstream probe((prevFile + ha::OutputFile::extension(CODECS[c])).c_str());
+    if (probe.is_open()) {
+      prevFile += ha::OutputFile::extension(CODECS[c]);
+      break;
+    }
+  }
+  std::string outFile = p_args.results_dir + "/similarity-scores.dat" + ha::OutputFile::extension(codec);
+  std::string tmpFile = p_args.results_dir + "/similarity-scores.dat.tmp";
+
+  ha::InputFile prev(prevFile);
+  if (!prev.is_open()) {
+    std::cerr << "Could not open file: " << prevFile << std::endl;
+    return false;
+  }
+  ha::OutputFile out;
+  if (!out.open(tmpFile, codec, p_args.compress_threads)) {
+    std::cerr << "Could not open file: " << tmpFile << ha::OutputFile::extension(codec) << std::endl;
+    return false;
+  }
+  tmpFile += ha::OutputFile::extension(codec);
+
+  // the previous matrix is streamed row by row, dropping the removed columns
+  for (boost::uint32_t i = 0; i < p_set_1.size(); ++i) {
+    for (boost::uint32_t j = 0; j < p_set_2.size(); ++j) {
+      if (!std::getline(prev, line)) {
+        std::cerr << "The previous score matrix " << prevFile << " is truncated!" << std::endl;
+        out.close();
+        std::remove(tmpFile.c_str());
+        return false;
+      }
+      if (keep[j]) {
+        out << line << std::endl;
+      }
+    }
+    for (boost::uint32_t j = 0; j < added.size(); ++j) {
+      out << scores.scores()[i][j] << std::endl;
+    }
+  }
+  prev.close();
+  out.close();
+  if (!out) {
+    std::cerr << "Could not write file: " << tmpFile << std::endl;
+    std::remove(tmpFile.c_str());
+    return false;
+  }
+
+  if (std::rename(tmpFile.c_str(), outFile.c_str()) != 0) {
+    std::cerr << "Could not rename " << tmpFile << " to " << outFile << std::endl;
+    return false;
+  }
+
+  // a matrix written with another codec, e.g., the one just updated in place, is stale now
+  for (boost::uint32_t c = 0; c < sizeof(CODECS) / sizeof(CODECS[0]); ++c) {
+    if (CODECS[c] != codec) {
+      std::remove((p_args.results_dir + "/similarity-scores.dat" + ha::OutputFile::extension(CODECS[c])).c_str());
+    }
+  }
+
+  // the updated set 2 is the input of the next update
+  ha::SequenceSet updated;
+  std::string setFile = p_args.results_dir + "/set_2.dat";
+  std::ofstream setOut(setFile.c_str(), std::ios::out);
+  for (boost::uint32_t j = 0; j < p_set_2.size(); ++j) {
+    if (keep[j]) {
+      updated.add(p_set_2.unique()[p_set_2.id(j)]);
+      writeSequence(setOut, p_set_2.unique()[p_set_2.id(j)]) << std::endl;
+    }
+  }
+  for (boost::uint32_t j = 0; j < added.size(); ++j) {
+    updated.add(added.unique()[added.id(j)]);
+    writeSequence(setOut, added.unique()[added.id(j)]) << std::endl;
+  }
+  setOut.close();
+
+  p_report << "Removed " << (p_set_2.size() - updated.size() + added.size()) << " and added " << added.size()
+            << " sequences of set 2" << std::endl;
+
+  current.assign(p_args, m_hierarchy, p_set_1, updated);
+  return current.save(p_args.results_dir + "/similarity-scores.fp");
+}
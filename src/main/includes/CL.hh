@@ -26,6 +26,9 @@
 # define __STDC_CONSTANT_MACROS
 #endif /* __STDC_CONSTANT_MACROS */
 
+#include <string>
+#include <vector>
+
 #include <boost/cstdint.hpp>
 
 #include <boost/program_options/options_description.hpp>
@@ -40,55 +43,177 @@ namespace po = boost::program_options;
 const std::string HELP = "help";
 const std::string VERS = "version";
 
+const std::string MODE = "mode";
+const std::string SOCKET = "socket";
+const std::string TOP_K = "top_k";
+
+const std::string PREVIOUS = "previous";
+const std::string DELTA = "delta";
+const std::string EXTEND = "extend";
+
 const std::string RESULTS_DIR = "results";
 const std::string EULER_LEVELS = "euler_levels";
 const std::string EULER_POSITIONS = "euler_positions";
 const std::string LCA = "lca";
 const std::string SET_1 = "set_1";
 const std::string SET_2 = "set_2";
+const std::string ALIGNMENTS = "alignments";
+const std::string COMPRESS = "compress";
+const std::string COMPRESS_THREADS = "compress_threads";
+const std::string JOBS = "jobs";
+const std::string AGGREGATE = "aggregate";
+const std::string AGG_BINS = "agg_bins";
+const std::string AGG_MIN = "agg_min";
+const std::string AGG_MAX = "agg_max";
+const std::string AGG_THRESHOLDS = "agg_thresholds";
 const std::string ALG = "alg";
 const std::string SCORES = "scores";
 const std::string GAP_PENALTY = "gap_penalty";
+const std::string RLE = "rle";
+const std::string NORM = "norm";
+const std::string SEED_K = "seed_k";
+const std::string SEED_LEVEL = "seed_level";
+const std::string SEED_MIN = "seed_min";
+const std::string COARSE_LEVEL = "coarse_level";
+const std::string COARSE_MIN = "coarse_min";
+const std::string XDROP = "xdrop";
+const std::string SWEEP = "sweep";
+const std::string TRIE = "trie";
+const std::string SKETCH_K = "sketch_k";
+const std::string SKETCH_SIZE = "sketch_size";
+const std::string SKETCH_SAMPLE = "sketch_sample";
+const std::string NUMA = "numa";
+const std::string HUGE_PAGES = "huge_pages";
+const std::string DP_CAP = "dp_cap";
+const std::string WAVEFRONT = "wavefront";
+const std::string WAVEFRONT_TILE = "wavefront_tile";
+const std::string MEM_LIMIT = "mem_limit";
 
 
 /** @struct
  * structure specifying the command line variables.
  */
 struct args_t {
+  std::string mode;               /* align the sets or serve queries against set 2 */
+  std::string socket;             /* Unix domain socket of the server, stdin/stdout if empty */
+  boost::uint32_t top_k;          /* number of best matches returned per query by the server */
+  std::string previous;           /* results directory of the run to update */
+  std::string delta;              /* Filename of the sequences added to and removed from set 2 */
+  bool extend;                    /* Indicate whether the frontiers of the previous run are extended */
   std::string results_dir;        /* directory name for the results */
   std::string euler_levels;       /* Levels of the vertices in the euler circuit */
   std::string euler_positions;    /* Positions of the vertices in the euler circuit */
   std::string lca;                /* Filename with the LCAs computed offline */
   std::string set_1;              /* Set of source sequences */
   std::string set_2;              /* Set of target sequences */
-  boost::int32_t alg;             /* The similarity algorithm to use: 1-SW, 2-NW */
+  std::string alignments;         /* format of the alignment output: tsv, binary, or none if empty */
+  std::string compress;           /* compression of the outputs: gzip, zstd, or none if empty */
+  boost::uint32_t compress_threads; /* number of threads compressing the outputs */
+  std::string jobs;               /* Filename of the manifest of jobs, a single job if empty */
+  boost::int32_t aggregate;       /* The aggregates of the rows: 0-none, 1-next to the matrix, 2-instead of the matrix */
+  boost::uint32_t agg_bins;       /* number of bins of the histograms of the rows */
+  double agg_min;                 /* lower bound of the first bin */
+  double agg_max;                 /* upper bound of the last bin */
+  std::vector<double> agg_thresholds; /* thresholds of the counts of the rows */
+  boost::int32_t alg;             /* The similarity algorithm to use: 1-SW, 2-NW, 3-SW and NW scores, 4-approximate SW */
   bool scores;                    /* Indicate whether only scores should be computed */
   double gap_penalty;             /* gap penalty */
+  bool rle;                       /* Indicate whether the scores are computed on runs of symbols */
+  boost::int32_t norm;            /* The normalisation of the scores: 1-squared min, 2-max length, 3-self scores, 4-raw */
+  boost::uint32_t seed_k;         /* length of the seeds, 0 disables the seed filter */
+  boost::uint32_t seed_level;     /* level of the hierarchy the seeds are projected onto */
+  boost::uint32_t seed_min;       /* minimum number of shared seeds of a candidate pair */
+  boost::uint32_t coarse_level;   /* level of the coarse alignments, 0 disables them */
+  double coarse_min;              /* minimum normalised coarse score of a candidate pair */
+  double xdrop;                   /* X-drop of the local alignments, 0 computes the whole matrices */
+  std::vector<double> sweep;      /* gap penalties scored in one pass, empty for just the gap penalty */
+  bool trie;                      /* Indicate whether the rows of common prefixes of set 1 are shared */
+  boost::uint32_t sketch_k;       /* length of the k-mers of the sketches */
+  boost::uint32_t sketch_size;    /* number of hashes of a sketch */
+  boost::uint32_t sketch_sample;  /* number of pairs aligned to calibrate the approximate scores */
+  bool numa;                      /* Indicate whether the workers are pinned to NUMA nodes with local replicas */
+  boost::int32_t huge_pages;      /* The pages of the matrices and score tables: 0-small, 1-transparent huge, 2-explicit huge */
+  boost::uint32_t dp_cap;         /* MiB of the matrices of a worker, 0 for no limit */
+  boost::uint32_t wavefront;      /* million cells of a pair computed by all workers together, 0 for none */
+  boost::uint32_t wavefront_tile; /* rows and columns of the tiles of such a pair */
+  boost::uint32_t mem_limit;      /* MiB of the whole process the execution is planned for, 0 for no limit */
 
   args_t(args_t const &args)
-      : results_dir(args.results_dir),
+      : mode(args.mode), socket(args.socket), top_k(args.top_k),
+        previous(args.previous), delta(args.delta), extend(args.extend), results_dir(args.results_dir),
         euler_levels(args.euler_levels), euler_positions(args.euler_positions),
-        lca(args.lca), set_1(args.set_1), set_2(args.set_2), alg(args.alg), scores(args.scores),
-        gap_penalty(args.gap_penalty)
+        lca(args.lca), set_1(args.set_1), set_2(args.set_2), alignments(args.alignments),
+        compress(args.compress), compress_threads(args.compress_threads), jobs(args.jobs),
+        aggregate(args.aggregate), agg_bins(args.agg_bins), agg_min(args.agg_min), agg_max(args.agg_max),
+        agg_thresholds(args.agg_thresholds), alg(args.alg), scores(args.scores),
+        gap_penalty(args.gap_penalty), rle(args.rle), norm(args.norm), seed_k(args.seed_k), seed_level(args.seed_level),
+        seed_min(args.seed_min), coarse_level(args.coarse_level), coarse_min(args.coarse_min), xdrop(args.xdrop), sweep(args.sweep), trie(args.trie),
+        sketch_k(args.sketch_k), sketch_size(args.sketch_size), sketch_sample(args.sketch_sample), numa(args.numa), huge_pages(args.huge_pages), dp_cap(args.dp_cap),
+        wavefront(args.wavefront), wavefront_tile(args.wavefront_tile), mem_limit(args.mem_limit)
   {}
 
   args_t()
-      : results_dir(""), euler_levels(""), euler_positions(""), lca(""), set_1(""), set_2(""),
-        alg(1), scores(0), gap_penalty(1.33)
+      : mode("align"), socket(""), top_k(10), previous(""), delta(""), extend(0), results_dir(""), euler_levels(""), euler_positions(""), lca(""), set_1(""), set_2(""), alignments(""),
+        compress(""), compress_threads(2), jobs(""),
+        aggregate(0), agg_bins(10), agg_min(0.0), agg_max(1.0), agg_thresholds(),
+        alg(1), scores(0), gap_penalty(1.33), rle(0), norm(1), seed_k(0), seed_level(1), seed_min(1),
+        coarse_level(0), coarse_min(0.5), xdrop(0.0), sweep(), trie(0), sketch_k(2), sketch_size(128), sketch_sample(1000), numa(0), huge_pages(0), dp_cap(0),
+        wavefront(64), wavefront_tile(256), mem_limit(0)
   {}
 
   friend std::ostream& operator <<(std::ostream &p_os, const args_t &p_args)
   {
     p_os << "Parameters" << std::endl << std::endl;
-    p_os << "Results directory: " << p_args.results_dir << std::endl
+    p_os << "Mode:              " << p_args.mode << std::endl
+         << "Socket:            " << p_args.socket << std::endl
+         << "Top k:             " << p_args.top_k << std::endl
+         << "Previous results:  " << p_args.previous << std::endl
+         << "Delta of set 2:    " << p_args.delta << std::endl
+         << "Extend frontiers:  " << p_args.extend << std::endl
+         << "Results directory: " << p_args.results_dir << std::endl
          << "Euler Levels:      " << p_args.euler_levels << std::endl
          << "Euler Positions:   " << p_args.euler_positions << std::endl
          << "LCAs:              " << p_args.lca << std::endl
          << "Set 1:             " << p_args.set_1 << std::endl
          << "Set 2:             " << p_args.set_2 << std::endl
+         << "Alignments:        " << p_args.alignments << std::endl
+         << "Compression:       " << p_args.compress << std::endl
+         << "Compress threads:  " << p_args.compress_threads << std::endl
+         << "Jobs:              " << p_args.jobs << std::endl
+         << "Aggregates:        " << p_args.aggregate << std::endl
+         << "Aggregate bins:    " << p_args.agg_bins << std::endl
+         << "Aggregate range:   " << p_args.agg_min << "," << p_args.agg_max << std::endl
+         << "Thresholds:        ";
+    for (std::size_t k = 0; k < p_args.agg_thresholds.size(); ++k) {
+      p_os << ((k > 0) ? "," : "") << p_args.agg_thresholds[k];
+    }
+    p_os << std::endl
          << "Algorithm:         " << p_args.alg << std::endl
          << "Just scores:       " << p_args.scores << std::endl
          << "Gap Penalty:       " << p_args.gap_penalty << std::endl
+         << "Run-length:        " << p_args.rle << std::endl
+         << "X-drop:            " << p_args.xdrop << std::endl
+         << "Sweep:             ";
+    for (std::size_t k = 0; k < p_args.sweep.size(); ++k) {
+      p_os << ((k > 0) ? "," : "") << p_args.sweep[k];
+    }
+    p_os << std::endl
+         << "Prefix trie:       " << p_args.trie << std::endl
+         << "Normalisation:     " << p_args.norm << std::endl
+         << "Seed Length:       " << p_args.seed_k << std::endl
+         << "Seed Level:        " << p_args.seed_level << std::endl
+         << "Seed Minimum:      " << p_args.seed_min << std::endl
+         << "Coarse Level:      " << p_args.coarse_level << std::endl
+         << "Coarse Minimum:    " << p_args.coarse_min << std::endl
+         << "Sketch Length:     " << p_args.sketch_k << std::endl
+         << "Sketch Size:       " << p_args.sketch_size << std::endl
+         << "Sketch Sample:     " << p_args.sketch_sample << std::endl
+         << "NUMA placement:    " << p_args.numa << std::endl
+         << "Huge pages:        " << p_args.huge_pages << std::endl
+         << "DP cap (MiB):      " << p_args.dp_cap << std::endl
+         << "Wavefront (Mcell): " << p_args.wavefront << std::endl
+         << "Wavefront tile:    " << p_args.wavefront_tile << std::endl
+         << "Memory limit:      " << p_args.mem_limit << std::endl
          << std::endl;
 
     return p_os;
@@ -119,6 +244,19 @@ class CL
    */
   int parse(int, char **, args_t &);
 
+  /** @fn parse(int argc, char *argv[], const std::vector<std::string> &job, args_t &args);
+   * Parse the options of a job of a manifest on top of the command-line
+   * parameters. The options of the job take precedence over the same
+   * options of the command line. The parameters are not printed.
+   *
+   * @param int number of command-line arguments
+   * @param char** the command-line arguments
+   * @param const std::vector<std::string> & the options of the job
+   * @param args_t a reference to the structure of the arguments of the job
+   * @return either success or failure. In case of a failure the error is reported on std::cerr.
+   */
+  int parse(int, char **, const std::vector<std::string> &, args_t &);
+
  private:
 
   /**
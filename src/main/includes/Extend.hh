@@ -0,0 +1,71 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+
+/** @file Extend.hh
+ * Declaration of the extension of the scores of grown sequences.
+ *
+ * @author Dominik Dahlem
+ */
+#ifndef __MAIN_EXTEND_HH__
+#define __MAIN_EXTEND_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "CL.hh"
+
+#include "Aligner.hh"
+#include "SequenceSet.hh"
+
+
+/** @class Extend
+ *
+ * This class aligns the sets by extending the frontiers of the previous
+ * run, if any, to the sequences that grew by appended symbols since.
+ * A sequence grew from the sequence at the same position of the
+ * previous set, if that is a prefix of it. The parameters and the
+ * hierarchy of the previous run have to match this run, otherwise the
+ * frontiers are not extended. The frontiers of this run are written to
+ * the results directory for the next run.
+ */
+class Extend : boost::noncopyable
+{
+ public:
+  Extend(ha::Aligner &p_aligner, boost::uint64_t p_hierarchy) : m_aligner(p_aligner), m_hierarchy(p_hierarchy) {}
+
+  /** @fn bool apply(const args_t &p_args, ha::SequenceSet &p_set_1, ha::SequenceSet &p_set_2, ha::ScoreSink &p_sink)
+   * Align set 1 against the indexed set 2 and deliver the scores to the sink.
+   *
+   * @param const args_t & the command-line arguments naming the previous results
+   * @param ha::SequenceSet & set 1
+   * @param ha::SequenceSet & set 2, indexed by the aligner
+   * @param ha::ScoreSink & the receiver of the scores
+   * @return true, if the frontiers could be extended. Otherwise the error is reported on std::cerr.
+   */
+  bool apply(const args_t &p_args, ha::SequenceSet &p_set_1, ha::SequenceSet &p_set_2, ha::ScoreSink &p_sink);
+
+ private:
+  ha::Aligner &m_aligner;
+  boost::uint64_t m_hierarchy;      /* hash of the hierarchy files of the fingerprints */
+};
+
+
+#endif
@@ -0,0 +1,110 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Fingerprint.hh
+ * Declaration of the fingerprints of the inputs of a score matrix.
+ *
+ * @author Dominik Dahlem
+ */
+#ifndef __MAIN_FINGERPRINT_HH__
+#define __MAIN_FINGERPRINT_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "CL.hh"
+
+#include "SequenceSet.hh"
+#include "Types.hh"
+
+
+/** @class Fingerprint
+ *
+ * This class records what a score matrix was computed from: the
+ * parameters the scores depend on, a hash of the hierarchy files and
+ * a content hash of every sequence of both sets in their input order.
+ * It is written next to the score matrix, so that a later run can
+ * check that the matrix can be updated instead of recomputed.
+ */
+class Fingerprint
+{
+ public:
+  Fingerprint() : m_hierarchy(0) {}
+
+  /** @fn void assign(const args_t &p_args, boost::uint64_t p_hierarchy, ha::SequenceSet &p_set_1, ha::SequenceSet &p_set_2)
+   * Fingerprint the parameters, the hierarchy and the sets of a run.
+   *
+   * @param const args_t & the arguments of the run
+   * @param boost::uint64_t the hash of the hierarchy files, see hashHierarchy
+   * @param ha::SequenceSet & set 1
+   * @param ha::SequenceSet & set 2
+   */
+  void assign(const args_t &p_args, boost::uint64_t p_hierarchy, ha::SequenceSet &p_set_1, ha::SequenceSet &p_set_2);
+
+  /** @fn bool load(const std::string &p_filename)
+   * @return true, if the fingerprint could be read. Otherwise the error is reported on std::cerr.
+   */
+  bool load(const std::string &p_filename);
+
+  /** @fn bool save(const std::string &p_filename) const
+   * @return true, if the fingerprint could be written. Otherwise the error is reported on std::cerr.
+   */
+  bool save(const std::string &p_filename) const;
+
+  /** @fn bool matches(const Fingerprint &p_other, bool p_set_2) const
+   * @return true, if the parameters, the hierarchy and set 1 (and set 2, if requested) are the same
+   */
+  bool matches(const Fingerprint &p_other, bool p_set_2) const;
+
+  /** @fn bool compatible(const Fingerprint &p_other) const
+   * @return true, if the parameters and the hierarchy are the same
+   */
+  bool compatible(const Fingerprint &p_other) const;
+
+  /** @fn static boost::uint64_t hash(const common::StringVec &p_seq)
+   * @return the 64-bit FNV-1a hash of the symbols of a sequence
+   */
+  static boost::uint64_t hash(const common::StringVec &p_seq);
+
+  /** @fn static bool hashHierarchy(const args_t &p_args, boost::uint64_t &p_hash)
+   * Hash the hierarchy files of the arguments. They are read once per
+   * process, the hash is shared by all runs against the hierarchy.
+   *
+   * @return true, if the hierarchy files could be read. Otherwise the error is reported on std::cerr.
+   */
+  static bool hashHierarchy(const args_t &p_args, boost::uint64_t &p_hash);
+
+ private:
+  static void hash(const char *p_data, std::size_t p_size, boost::uint64_t &p_hash);
+  static void hash(const std::string &p_str, boost::uint64_t &p_hash);
+  static void hash(ha::SequenceSet &p_set, std::vector<boost::uint64_t> &p_hashes);
+  static bool hashFile(const std::string &p_filename, boost::uint64_t &p_hash);
+
+  std::string m_params;
+  boost::uint64_t m_hierarchy;
+  std::vector<boost::uint64_t> m_set_1;
+  std::vector<boost::uint64_t> m_set_2;
+};
+
+
+#endif
@@ -0,0 +1,94 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Job.hh
+ * Declaration of the comparison of two sets.
+ *
+ * @author Dominik Dahlem
+ */
+#ifndef __MAIN_JOB_HH__
+#define __MAIN_JOB_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <ostream>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "CL.hh"
+
+#include "Aligner.hh"
+#include "SequenceSet.hh"
+
+
+/** @class Job
+ *
+ * This class compares set 1 against set 2 of the arguments: it loads
+ * both sets, aligns them, updates or extends the previous results if
+ * requested, and writes the score matrices, the alignments and the
+ * fingerprint to the results directory.
+ */
+class Job : boost::noncopyable
+{
+ public:
+  Job(ha::Aligner &p_aligner, boost::uint64_t p_hierarchy) : m_aligner(p_aligner), m_hierarchy(p_hierarchy) {}
+
+  /** @fn static ha::alignOptions options(const args_t &p_args)
+   * @return the options of the aligner of the arguments
+   */
+  static ha::alignOptions options(const args_t &p_args);
+
+  /** @fn static bool load(const args_t &p_args, ha::SequenceSet &p_seqs_1, ha::SequenceSet &p_seqs_2, std::ostream &p_report)
+   * Load the sets of the arguments and report their sizes.
+   *
+   * @param const args_t & the arguments of the comparison
+   * @param ha::SequenceSet & set 1
+   * @param ha::SequenceSet & set 2
+   * @param std::ostream & the receiver of the sizes of the sets
+   * @return true, if both sets could be read. Otherwise the error is reported on std::cerr.
+   */
+  static bool load(const args_t &p_args, ha::SequenceSet &p_seqs_1, ha::SequenceSet &p_seqs_2, std::ostream &p_report);
+
+  /** @fn bool apply(const args_t &p_args, std::ostream &p_report)
+   * Compare the sets of the arguments and write the results.
+   *
+   * @param const args_t & the arguments of the comparison
+   * @param std::ostream & the receiver of the summary of the comparison
+   * @return true, if the results could be written. Otherwise the error is reported on std::cerr.
+   */
+  bool apply(const args_t &p_args, std::ostream &p_report);
+
+  /** @fn bool apply(const args_t &p_args, ha::SequenceSet &p_seqs_1, ha::SequenceSet &p_seqs_2, std::ostream &p_report)
+   * Compare the loaded sets of the arguments and write the results.
+   *
+   * @param const args_t & the arguments of the comparison
+   * @param ha::SequenceSet & set 1
+   * @param ha::SequenceSet & set 2
+   * @param std::ostream & the receiver of the summary of the comparison
+   * @return true, if the results could be written. Otherwise the error is reported on std::cerr.
+   */
+  bool apply(const args_t &p_args, ha::SequenceSet &p_seqs_1, ha::SequenceSet &p_seqs_2, std::ostream &p_report);
+
+ private:
+  ha::Aligner &m_aligner;
+  boost::uint64_t m_hierarchy;      /* hash of the hierarchy files of the fingerprints */
+};
+
+
+#endif
@@ -0,0 +1,91 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Jobs.hh
+ * Declaration of the comparisons of a manifest of jobs against one hierarchy.
+ *
+ * @author Dominik Dahlem
+ */
+#ifndef __MAIN_JOBS_HH__
+#define __MAIN_JOBS_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "CL.hh"
+
+#include "Hierarchy.hh"
+#include "TreePathSimilarityMeasure.hh"
+
+
+/** @class Jobs
+ *
+ * This class runs the jobs of a manifest against the hierarchy loaded
+ * once. Every line of the manifest lists the options of a job in the
+ * syntax of the command line, which override the options of the
+ * command line; '#' starts a comment. The jobs of the same gap penalty
+ * share the scoring scheme. The cost of a job is estimated from the
+ * sizes of its sets. The jobs of at least the share of a worker in the
+ * total cost are run one after the other by all workers, the remaining
+ * jobs are dealt out to the workers one job per worker, the largest
+ * first, so that the small jobs keep all workers busy instead of
+ * leaving most of them idle.
+ */
+class Jobs : boost::noncopyable
+{
+ public:
+  Jobs(ha::Hierarchy &p_hierarchy) : m_hierarchy(p_hierarchy) {}
+
+  /** @fn bool apply(CL &p_cl, int argc, char *argv[], const args_t &p_args)
+   * Run all jobs of the manifest of the arguments.
+   *
+   * @param CL & the parser of the options of the jobs
+   * @param int number of command-line arguments
+   * @param char** the command-line arguments
+   * @param const args_t & the command-line arguments naming the manifest
+   * @return true, if all jobs succeeded. Otherwise the errors are reported on std::cerr.
+   */
+  bool apply(CL &p_cl, int argc, char *argv[], const args_t &p_args);
+
+ private:
+  /** @struct job_t
+   * structure holding a job of the manifest.
+   */
+  struct job_t {
+    args_t args;                /* the arguments of the job */
+    boost::uint32_t line;       /* line of the job in the manifest */
+    boost::uint64_t cost;       /* estimated cost of the job */
+  };
+
+  typedef std::map<double, boost::shared_ptr<const ha::TreePathSimilarityMeasure> > Schemes;
+
+  bool read(CL &p_cl, int argc, char *argv[], const args_t &p_args, std::vector<job_t> &p_jobs) const;
+  bool run(const job_t &p_job, bool p_shared, const Schemes &p_schemes, boost::uint64_t p_hierarchy);
+
+  ha::Hierarchy &m_hierarchy;
+};
+
+
+#endif
@@ -0,0 +1,101 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Plan.hh
+ * Declaration of the plan of a comparison within a memory limit.
+ *
+ * @author Dominik Dahlem
+ */
+#ifndef __MAIN_PLAN_HH__
+#define __MAIN_PLAN_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <ostream>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "CL.hh"
+
+#include "Aligner.hh"
+#include "Hierarchy.hh"
+#include "SequenceSet.hh"
+
+
+/** @class Plan
+ *
+ * This class plans the comparison of two loaded sets within the
+ * memory limit of the arguments. It estimates the bytes of the
+ * hierarchy, the scoring scheme, the sets, their indexes, the output
+ * buffers and the rows of scores kept for the repeated sequences of
+ * set 1, which are fixed, and of the matrices of every worker, which
+ * grow with the longest pair or, for the self-alignments, with the
+ * longest sequence. It then chooses the number of workers,
+ * the kernel, the tiles of the wavefront and whether the rows of set 1
+ * are kept or streamed, and reports the plan before the comparison
+ * starts:
+ *
+ * - The rows of repeated sequences get at most half of the memory
+ *   left by the fixed parts. Beyond that, they are streamed: a row
+ *   that does not fit into the rest is computed again at the next
+ *   position of its sequence. The prefix trie, which keeps the
+ *   scores of all pairs, is turned off, if they do not fit.
+ * - All workers keep the full matrices of the longest pair, if they
+ *   fit. If the alignments are written, the number of workers is
+ *   reduced first, so that every pair keeps its alignment.
+ * - Otherwise the matrices of every worker are capped and the larger
+ *   pairs are scored in linear space. The workers are only reduced,
+ *   if they cannot keep two rows of the longest pair.
+ * - The tiles of the pairs scored by the wavefront are enlarged until
+ *   their corners take at most half of the memory of the workers.
+ */
+class Plan : boost::noncopyable
+{
+ public:
+  Plan(ha::Hierarchy &p_hierarchy) : m_hierarchy(p_hierarchy) {}
+
+  /** @fn bool apply(const args_t &p_args, ha::SequenceSet &p_seqs_1, ha::SequenceSet &p_seqs_2, ha::alignOptions &p_options, std::ostream &p_report)
+   * Plan the comparison of the loaded sets within the memory limit and
+   * set the number of threads of the workers.
+   *
+   * @param const args_t & the arguments of the comparison
+   * @param ha::SequenceSet & set 1
+   * @param ha::SequenceSet & set 2
+   * @param ha::alignOptions & the options of the aligner, adjusted to the plan
+   * @param std::ostream & the receiver of the plan
+   * @return true, if the comparison fits into the limit. Otherwise the error is reported on std::cerr.
+   */
+  bool apply(const args_t &p_args, ha::SequenceSet &p_seqs_1, ha::SequenceSet &p_seqs_2,
+             ha::alignOptions &p_options, std::ostream &p_report);
+
+ private:
+  boost::uint64_t hierarchy() const;
+  boost::uint64_t scheme() const;
+  static boost::uint64_t symbols(ha::SequenceSet &p_seqs);
+  static boost::uint32_t longest(ha::SequenceSet &p_seqs);
+  static boost::uint64_t sequences(ha::SequenceSet &p_seqs);
+  static boost::uint32_t live(ha::SequenceSet &p_seqs);
+  static boost::uint64_t wavefront(boost::uint32_t p_rows, boost::uint32_t p_cols, boost::uint32_t p_tile,
+                                   boost::uint32_t p_threads);
+
+  ha::Hierarchy &m_hierarchy;
+};
+
+
+#endif
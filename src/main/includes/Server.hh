@@ -0,0 +1,75 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Server.hh
+ * Declaration of the persistent query server.
+ *
+ * @author Dominik Dahlem
+ */
+#ifndef __MAIN_SERVER_HH__
+#define __MAIN_SERVER_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <iostream>
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "Aligner.hh"
+#include "SequenceSet.hh"
+
+
+/** @class Server
+ *
+ * This class answers queries against an indexed reference set with a
+ * line protocol. Every request is a line of comma-separated symbols and
+ * is answered with at most k lines "<target position>\t<score>" in
+ * descending order of the scores, followed by an empty line. The
+ * hierarchy, the target index and the memory pools of the aligner stay
+ * warm across the requests.
+ */
+class Server : boost::noncopyable
+{
+ public:
+  Server(ha::Aligner &p_aligner, ha::SequenceSet &p_targets, boost::uint32_t p_k);
+
+  /** @fn void serve(std::istream &p_in, std::ostream &p_out)
+   * Answer the requests of a stream until it ends.
+   *
+   * @param std::istream & the requests
+   * @param std::ostream & the responses
+   */
+  void serve(std::istream &p_in, std::ostream &p_out);
+
+  /** @fn bool listen(const std::string &p_path)
+   * Answer the connections of a Unix domain socket one after the other.
+   *
+   * @param const std::string & the path of the socket
+   * @return false, if the socket could not be bound. Otherwise it does not return.
+   */
+  bool listen(const std::string &p_path);
+
+ private:
+  ha::Aligner &m_aligner;
+  boost::uint32_t m_k;
+};
+
+
+#endif
@@ -0,0 +1,74 @@
+// Copyright (C) 2015 Dominik Dahlem <Dominik.Dahlem@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+/** @file Update.hh
+ * Declaration of the incremental update of a score matrix.
+ *
+ * @author Dominik Dahlem
+ */
+#ifndef __MAIN_UPDATE_HH__
+#define __MAIN_UPDATE_HH__
+
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif /* __STDC_CONSTANT_MACROS */
+
+#include <ostream>
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "CL.hh"
+
+#include "Aligner.hh"
+#include "SequenceSet.hh"
+
+
+/** @class Update
+ *
+ * This class updates the score matrix of a previous run to a changed
+ * set 2. The delta file lists one sequence per line, prefixed with '+'
+ * for a sequence appended to set 2 and with '-' for the first remaining
+ * occurrence of a sequence removed from set 2. Only set 1 against the
+ * appended sequences is aligned, the scores of the remaining columns
+ * are copied from the previous matrix. The fingerprint of the previous
+ * run has to match the parameters, the hierarchy and both sets of this
+ * run, otherwise the matrix is not updated.
+ */
+class Update : boost::noncopyable
+{
+ public:
+  Update(ha::Aligner &p_aligner, boost::uint64_t p_hierarchy) : m_aligner(p_aligner), m_hierarchy(p_hierarchy) {}
+
+  /** @fn bool apply(const args_t &p_args, ha::SequenceSet &p_set_1, ha::SequenceSet &p_set_2, std::ostream &p_report)
+   * Write the updated score matrix, the updated set 2 and their fingerprint to the results directory.
+   *
+   * @param const args_t & the command-line arguments naming the previous results and the delta
+   * @param ha::SequenceSet & set 1 of the previous run
+   * @param ha::SequenceSet & set 2 of the previous run
+   * @param std::ostream & the receiver of the summary of the update
+   * @return true, if the matrix could be updated. Otherwise the error is reported on std::cerr.
+   */
+  bool apply(const args_t &p_args, ha::SequenceSet &p_set_1, ha::SequenceSet &p_set_2, std::ostream &p_report);
+
+ private:
+  ha::Aligner &m_aligner;
+  boost::uint64_t m_hierarchy;      /* hash of the hierarchy files of the fingerprints */
+};
+
+
+#endif